@@ -0,0 +1,29 @@
+#ifndef BENCH_H
+#define BENCH_H
+/**
+ * @file bench.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Benchmark helpers
+ * @version 0.1
+ * @date 2024-10-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Keep compiler from removing benchmarked code
+ *
+ */
+#define BENCH_KEEP(x)   __asm__ __volatile__("" : : "r"(x) : "memory")
+
+#endif // BENCH_H
@@ -0,0 +1,157 @@
+/**
+ * @file bench_calc.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Benchmark of pwm_calc() over sweep of target frequencies
+ * @version 0.1
+ * @date 2024-10-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+
+#include "soc.h"
+#include "config.h"
+#include "bench.h"
+
+#define SWEEP_POINTS    2000
+#define SOLVE_RUNS      32      // per solve time is minimum of runs (noise)
+
+/**
+ * @brief Worst case budget of single solve on host. pwm_calc() must take
+ *        microseconds on Cortex-A7, only checked in optimized builds
+ */
+#ifndef CALC_BUDGET_NS
+#define CALC_BUDGET_NS  5000
+#endif
+
+/**
+ * @brief Reference solver: every source, divider and pre-scaler with
+ *        rounded cycles (one division per divider)
+ *
+ */
+static void calc_ref(uint64_t period_ns, struct pwm_config *config)
+{
+    static const struct {
+        enum clk_src src;
+        uint64_t freq;
+    } srcs[] = {{HOSC, HOSC_FREQ}, {APB0, APB0_FREQ}};
+    // 1/3 nS makes clock period integer for both sources
+    uint64_t target = period_ns * 3;
+    uint64_t best_err = UINT64_MAX;
+    uint64_t best_cycles = 0;
+
+    for(uint8_t s = 0; s < 2; s++)
+        for(uint8_t div = DIV_1; div <= DIV_256; div++)
+            for(uint32_t m = (div == DIV_1) ? 1 : 129; m <= 256; m++) {
+                uint64_t q = ((3 * NSEC_IN_SEC / srcs[s].freq) * m) << div;
+                uint64_t cycles = (target + q / 2) / q;
+                if(cycles < 1)
+                    cycles = 1;
+                if(cycles > 65536)
+                    cycles = 65536;
+                uint64_t actual = cycles * q;
+                uint64_t err = (actual > target) ? actual - target : target - actual;
+                if(err < best_err || (err == best_err && cycles > best_cycles)) {
+                    best_err = err;
+                    best_cycles = cycles;
+                    config->clk.src = srcs[s].src;
+                    config->clk.div = div;
+                    config->pre = m - 1;
+                    config->period.entire = cycles - 1;
+                }
+            }
+}
+
+static int same(const struct pwm_config *a, const struct pwm_config *b)
+{
+    return a->clk.src == b->clk.src && a->clk.div == b->clk.div && a->pre == b->pre &&
+           a->period.entire == b->period.entire;
+}
+
+int main()
+{
+    uint64_t max_ns, min_ns;
+    pwm_min_max_period(&max_ns, &min_ns);
+    printf("period range: %llu nS ... %llu nS\n",
+           (unsigned long long)min_ns, (unsigned long long)max_ns);
+
+    // 1 mS is exact on HOSC (24000 cycles) and APB0 / 2 (50000 cycles), more cycles win
+    struct pwm_config check;
+    int32_t ret = pwm_calc(1000000, 50, &check);
+    if(ret || check.clk.src != APB0 || check.clk.div != DIV_1 || check.pre != 1 ||
+       check.period.entire != 49999) {
+        printf("pwm_calc(1 mS) mismatch: ret %d src %d div %d pre %d entire %u\n", ret,
+               check.clk.src, check.clk.div, check.pre, check.period.entire);
+        return 1;
+    }
+
+    // logarithmic sweep from 1 Hz to 10 MHz
+    double worst_err = 0;
+    uint64_t worst_ns = 0;
+    uint64_t worst_period = 0;
+    uint64_t total_ns = 0;
+    uint32_t mismatch = 0;
+    for(uint32_t i = 0; i < SWEEP_POINTS; i++) {
+        double freq = 1.0;
+        for(uint32_t j = 0; j < i; j++)
+            freq *= 1.0081;
+        uint64_t period_ns = NSEC_IN_SEC / freq;
+
+        struct pwm_config config;
+        uint64_t elapsed = UINT64_MAX;
+        for(uint32_t run = 0; run < SOLVE_RUNS; run++) {
+            uint64_t start = bench_now_ns();
+            ret = pwm_calc(period_ns, 50, &config);
+            BENCH_KEEP(&config);
+            uint64_t ns = bench_now_ns() - start;
+            if(ns < elapsed)
+                elapsed = ns;
+        }
+        if(ret) {
+            printf("%llu nS: error %d\n", (unsigned long long)period_ns, ret);
+            continue;
+        }
+
+        total_ns += elapsed;
+        if(elapsed > worst_ns) {
+            worst_ns = elapsed;
+            worst_period = period_ns;
+        }
+
+        struct pwm_config ref = {0};
+        calc_ref(period_ns, &ref);
+        if(!same(&config, &ref) && mismatch++ < 5)
+            printf("%llu nS: src %d div %d pre %d entire %u, reference src %d div %d pre %d "
+                   "entire %u\n", (unsigned long long)period_ns, config.clk.src,
+                   config.clk.div, config.pre, config.period.entire, ref.clk.src,
+                   ref.clk.div, ref.pre, ref.period.entire);
+
+        double clk_ns = 1e9 / (config.clk.src == APB0 ? APB0_FREQ : HOSC_FREQ);
+        double actual = clk_ns * (1 << config.clk.div) * (config.pre + 1) *
+                        (config.period.entire + 1);
+        double err = (actual - period_ns) / period_ns;
+        if(err < 0)
+            err = -err;
+        if(err > worst_err)
+            worst_err = err;
+    }
+
+    printf("%d solves, avg: %llu nS, worst: %llu nS (%llu nS period), budget: %u nS\n",
+           SWEEP_POINTS, (unsigned long long)(total_ns / SWEEP_POINTS),
+           (unsigned long long)worst_ns, (unsigned long long)worst_period, CALC_BUDGET_NS);
+    printf("worst period error: %.6f %%, reference mismatches: %u\n", worst_err * 100,
+           mismatch);
+
+    if(mismatch)
+        return 1;
+
+#ifdef __OPTIMIZE__
+    if(worst_ns > CALC_BUDGET_NS)
+        return 1;
+#else
+    printf("budget not checked (unoptimized build)\n");
+#endif
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file bench_convert.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Samples per second of batch capture conversion (scalar vs SIMD)
+ * @version 0.1
+ * @date 2024-10-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+
+#include "backend.h"
+#include "cap_convert.h"
+#include "bench.h"
+
+#define SAMPLES     4096
+#define ROUNDS      2048
+
+static struct cap_result_raw raw[SAMPLES];
+static struct cap_sample ref[SAMPLES];
+static struct cap_sample simd[SAMPLES];
+
+int main()
+{
+    struct rw_backend be;
+    if(rw_open_ram(&be)) {
+        perror("ram backend");
+        return 1;
+    }
+    void *p = be.base;
+
+    struct cap_config cap = {
+        .clk = {.src = HOSC, .div = DIV_4},
+        .pre = 6,
+        .rising = true,
+        .falling = true,
+    };
+    set_cap_config(p, 4, &cap);
+
+    struct pwm_timebase tb;
+    timebase_get(p, 4, &tb);
+
+    uint32_t seed = 1;
+    for(uint32_t i = 0; i < SAMPLES; i++) {
+        seed = seed * 1103515245 + 12345;
+        raw[i].on_cycles = seed >> 16;
+        raw[i].off_cycles = seed;
+    }
+    raw[0].on_cycles = raw[0].off_cycles = 0;
+    raw[1].on_cycles = raw[1].off_cycles = 65535;
+
+    // result_to_ns() per sample (timebase cache hit, no register access)
+    uint64_t start = bench_now_ns();
+    for(uint32_t r = 0; r < ROUNDS / 16; r++) {
+        for(uint32_t i = 0; i < SAMPLES; i++) {
+            struct cap_result res;
+            result_to_ns(p, 4, &raw[i], &res);
+            BENCH_KEEP(res.on_ns);
+        }
+    }
+    uint64_t single_ns = (bench_now_ns() - start) * 16;
+
+    start = bench_now_ns();
+    for(uint32_t r = 0; r < ROUNDS; r++) {
+        cap_convert_scalar(&tb, raw, ref, SAMPLES);
+        BENCH_KEEP(ref[r % SAMPLES].on_ns);
+    }
+    uint64_t scalar_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(uint32_t r = 0; r < ROUNDS; r++) {
+        cap_convert(&tb, raw, simd, SAMPLES);
+        BENCH_KEEP(simd[r % SAMPLES].on_ns);
+    }
+    uint64_t simd_ns = bench_now_ns() - start;
+
+    for(uint32_t i = 0; i < SAMPLES; i++) {
+        struct cap_result res;
+        result_to_ns(p, 4, &raw[i], &res);
+        if(ref[i].on_ns != simd[i].on_ns || ref[i].off_ns != simd[i].off_ns ||
+           ref[i].freq_hz != simd[i].freq_hz || ref[i].duty != simd[i].duty ||
+           ref[i].on_ns != res.on_ns || ref[i].off_ns != res.off_ns) {
+            fprintf(stderr, "mismatch at sample %u\n", i);
+            return 1;
+        }
+    }
+
+    double total = (double)SAMPLES * ROUNDS;
+    printf("result_to_ns(): %12.0f samples/s (nS only)\n", total * 1e9 / single_ns);
+    printf("scalar:         %12.0f samples/s\n", total * 1e9 / scalar_ns);
+    printf("%-6s          %12.0f samples/s (bit identical)\n", cap_convert_isa(), total * 1e9 / simd_ns);
+
+    rw_close(&be);
+    return 0;
+}
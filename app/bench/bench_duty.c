@@ -0,0 +1,61 @@
+/**
+ * @file bench_duty.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Benchmark of duty cycle updates (set_pwm_duty() vs fast path)
+ * @version 0.1
+ * @date 2024-10-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+
+#include "backend.h"
+#include "config.h"
+#include "bench.h"
+
+#define UPDATES     (1 << 22)
+
+int main()
+{
+    struct rw_backend be;
+    if(rw_open_ram(&be)) {
+        perror("ram backend");
+        return 1;
+    }
+    void *p = be.base;
+
+    struct pwm_config pwm = {
+        .clk = {.src = APB0, .div = DIV_1},
+        .period = {.entire = 65535, .act = 0},
+        .pre = 0,
+        .state = ACT_HIGH,
+        .en = true,
+    };
+    set_pwm_config(p, 2, &pwm);
+
+    uint64_t start = bench_now_ns();
+    for(uint32_t i = 0; i < UPDATES; i++)
+        set_pwm_duty(p, 2, i % 101);
+    uint64_t percent_ns = bench_now_ns() - start;
+
+    struct pwm_duty duty;
+    pwm_duty_init(p, 2, &duty);
+
+    start = bench_now_ns();
+    for(uint32_t i = 0; i < UPDATES; i++)
+        pwm_duty_frac(&duty, i);
+    uint64_t frac_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(uint32_t i = 0; i < UPDATES; i++)
+        pwm_duty_permille(&duty, i % 1001);
+    uint64_t permille_ns = bench_now_ns() - start;
+
+    printf("set_pwm_duty():      %10.0f updates/s (101 levels)\n", UPDATES * 1e9 / percent_ns);
+    printf("pwm_duty_frac():     %10.0f updates/s (%u levels)\n", UPDATES * 1e9 / frac_ns, duty.scale);
+    printf("pwm_duty_permille(): %10.0f updates/s (1001 levels)\n", UPDATES * 1e9 / permille_ns);
+
+    rw_close(&be);
+    return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file bench_log.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Append rate of capture log and zero copy replay into stats / conversion
+ * @version 0.1
+ * @date 2024-10-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cap_log.h"
+#include "cap_stats.h"
+#include "cap_convert.h"
+#include "bench.h"
+
+#define RECORDS     (1 << 22)
+#define BATCH       4096
+
+int main(int argc, char *argv[])
+{
+    const char *path = (argc > 1) ? argv[1] : "/tmp/bench_cap.log";
+    struct pwm_clk clk = {.src = APB0, .div = DIV_2};
+
+    struct cap_log log;
+    int32_t ret = cap_log_create(&log, path, RECORDS, 4, clk, 9);
+    if(ret) {
+        fprintf(stderr, "%s: create failed (%d)\n", path, ret);
+        return 1;
+    }
+
+    struct cap_event ev = {.ch = 4};
+    uint64_t start = bench_now_ns();
+    for(uint32_t i = 0; i < RECORDS; i++) {
+        ev.raw.on_cycles = 1000 + (i & 0x3F);
+        ev.raw.off_cycles = 3000 - (i & 0x3F);
+        ev.irq_count = 2 * i;
+        ev.ts_ns = start + 20000ULL * i;
+        cap_log_append(&log, &ev);
+    }
+    uint64_t append_ns = bench_now_ns() - start;
+    cap_log_close(&log);
+
+    ret = cap_log_open(&log, path);
+    if(ret) {
+        fprintf(stderr, "%s: open failed (%d)\n", path, ret);
+        return 1;
+    }
+
+    struct pwm_timebase tb;
+    cap_log_timebase(&log, &tb);
+
+    struct cap_stats stats;
+    cap_stats_init(&stats, 1.0 / 16);
+    static struct cap_sample out[BATCH];
+
+    // raw results are passed straight from mapping
+    uint64_t count = cap_log_count(&log);
+    start = bench_now_ns();
+    for(uint64_t i = 0; i < count; i += BATCH) {
+        uint32_t n = (count - i < BATCH) ? count - i : BATCH;
+        cap_stats_push_batch(&stats, &log.raw[i], n);
+        cap_convert(&tb, &log.raw[i], out, n);
+        BENCH_KEEP(out[n - 1].on_ns);
+    }
+    uint64_t replay_ns = bench_now_ns() - start;
+
+    struct cap_stats_snapshot snap;
+    cap_stats_snapshot(&stats, &tb, &snap);
+    cap_log_close(&log);
+    unlink(path);
+
+    printf("append:  %12.0f records/s\n", RECORDS * 1e9 / append_ns);
+    printf("replay:  %12.0f records/s (stats + %s conversion)\n",
+           count * 1e9 / replay_ns, cap_convert_isa());
+    printf("records: %llu, freq: %.1f Hz, duty: %.2f %%\n",
+           (unsigned long long)snap.count, snap.freq_hz, snap.duty);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file bench_range.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Auto-ranging capture on wrapped / fast counts and cost of in range check
+ * @version 0.1
+ * @date 2024-10-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+
+#include "backend.h"
+#include "cap_range.h"
+#include "bench.h"
+
+#define UPDATES     (1 << 22)
+
+static int32_t start(struct cap_range *r, void *p, enum clk_div div)
+{
+    struct cap_config cap = {
+        .clk = {.src = APB0, .div = div},
+        .pre = 0,
+        .falling = true,
+        .rising = true,
+    };
+
+    return cap_range_init(r, p, 4, &cap);
+}
+
+int main()
+{
+    struct rw_backend be;
+    if(rw_open_ram(&be)) {
+        perror("ram backend");
+        return 1;
+    }
+    void *p = be.base;
+
+    // slow pulse wraps 16bit lock registers: small count must slow clock down
+    struct cap_range r;
+    if(start(&r, p, DIV_1)) {
+        printf("cap_range_init() failed\n");
+        return 1;
+    }
+    struct cap_result_raw in = {.on_cycles = CAP_RANGE_TARGET, .off_cycles = 0x100};
+    struct cap_result_raw wrapped = {.on_cycles = 0x100, .off_cycles = 0x80};
+    cap_range_update(&r, &in);
+    uint32_t total = r.total;
+    int32_t ret = cap_range_update(&r, &wrapped);
+    if(ret != 1 || r.total <= total) {
+        printf("wrapped count: ret %d total %u -> %u (must raise divider)\n", ret, total, r.total);
+        return 1;
+    }
+
+    // still wrapped after probe (count didn't scale down): slow down again
+    total = r.total;
+    ret = cap_range_update(&r, &wrapped);
+    if(ret != 1 || r.total <= total) {
+        printf("wrapped after probe: ret %d total %u -> %u (must raise divider)\n", ret,
+               total, r.total);
+        return 1;
+    }
+
+    // real fast signal: count follows probe, then clock speeds up
+    if(start(&r, p, DIV_64)) {
+        printf("cap_range_init() failed\n");
+        return 1;
+    }
+    struct cap_result_raw fast = {.on_cycles = 0x100, .off_cycles = 0x100};
+    struct cap_result_raw scaled = {.on_cycles = 0x10, .off_cycles = 0x10};
+    cap_range_update(&r, &fast);
+    total = r.total;
+    ret = cap_range_update(&r, &scaled);
+    if(ret != 1 || r.total >= total) {
+        printf("fast signal: ret %d total %u -> %u (must lower divider)\n", ret, total, r.total);
+        return 1;
+    }
+
+    // in range results are the common case
+    uint64_t begin = bench_now_ns();
+    for(uint32_t i = 0; i < UPDATES; i++) {
+        in.off_cycles = i & 0xFF;
+        BENCH_KEEP(cap_range_update(&r, &in));
+    }
+    uint64_t elapsed = bench_now_ns() - begin;
+
+    printf("wrap / probe checks passed, %u retunes\n", r.retunes);
+    printf("cap_range_update(): %.1f nS per in range result\n", (double)elapsed / UPDATES);
+
+    rw_close(&be);
+    return 0;
+}
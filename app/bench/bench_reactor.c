@@ -0,0 +1,147 @@
+/**
+ * @file bench_reactor.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Round trip of capture reactor per interrupt (UIO emulated by socket)
+ * @version 0.1
+ * @date 2024-10-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "backend.h"
+#include "registers.h"
+#include "bitops.h"
+#include "irq.h"
+#include "cap_reactor.h"
+#include "bench.h"
+
+#define INTERRUPTS      (1 << 15)
+#define COUNT_BASE      100         // event count before reactor runs
+
+static struct cap_reactor reactor;
+static uint32_t results;
+static uint32_t last_count;
+static uint64_t reactor_cpu_ns;     // CPU time of reactor thread
+
+static void on_result(const struct cap_event *ev, void *arg)
+{
+    (void)arg;
+    results++;
+    last_count = ev->irq_count;
+}
+
+static uint64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *run(void *arg)
+{
+    (void)arg;
+    uint64_t start = thread_cpu_ns();
+    int32_t ret = cap_reactor_run(&reactor);
+    reactor_cpu_ns = thread_cpu_ns() - start;
+
+    return (void *)(intptr_t)ret;
+}
+
+/**
+ * @brief Event counts the reactor didn't read. Unlike UIO, socket queues
+ *        them, so it's drained before each interrupt (read() of reactor
+ *        returns current count as on UIO)
+ */
+static uint32_t drain(int fd)
+{
+    uint32_t counts[8];
+    ssize_t n = read(fd, counts, sizeof(counts));
+
+    return (n > 0) ? n / sizeof(uint32_t) : 0;
+}
+
+int main()
+{
+    struct rw_backend be;
+    if(rw_open_ram(&be)) {
+        perror("ram backend");
+        return 1;
+    }
+    void *p = be.base;
+
+    /**
+     * @brief sv[0] is UIO descriptor of reactor: 4 byte event count to read
+     *        and 4 byte irqcontrol writes. sv[1] is driver side
+     */
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) || pwm_irq_attach(p, sv[0])) {
+        perror("socketpair");
+        return 1;
+    }
+    if(cap_reactor_init(&reactor, p) || cap_reactor_add(&reactor, 0, on_result, NULL)) {
+        printf("reactor init failed\n");
+        return 1;
+    }
+
+    uint32_t count = COUNT_BASE;
+    if(write(sv[1], &count, sizeof(count)) != sizeof(count)) {
+        perror("write");
+        return 1;
+    }
+
+    pthread_t th;
+    if(pthread_create(&th, NULL, run, NULL)) {
+        perror("pthread_create");
+        return 1;
+    }
+
+    // re-arms of start up
+    usleep(100000);
+    uint32_t rearm[8];
+    while(recv(sv[1], rearm, sizeof(rearm), MSG_DONTWAIT) > 0)
+        ;
+    uint32_t unread = drain(sv[0]);
+
+    uint64_t start = bench_now_ns();
+    for(uint32_t i = 0; i < INTERRUPTS; i++) {
+        // both edges of channel 0 locked, then interrupt
+        unread += drain(sv[0]);
+        writel(p + CISR_OFFSET, BIT(CRISx(0)) | BIT(CFISx(0)));
+        count++;
+        if(write(sv[1], &count, sizeof(count)) != sizeof(count) ||
+           read(sv[1], rearm, sizeof(uint32_t)) != sizeof(uint32_t)) {
+            perror("emulated interrupt");
+            return 1;
+        }
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    unread += drain(sv[0]);
+
+    cap_reactor_stop(&reactor);
+    void *ret;
+    pthread_join(th, &ret);
+    if(ret) {
+        printf("cap_reactor_run(): %d\n", (int)(intptr_t)ret);
+        return 1;
+    }
+
+    printf("%u interrupts, %u results, last event count %u (expected %u)\n",
+           INTERRUPTS, results, last_count, count);
+    printf("round trip: %llu nS, reactor CPU: %llu nS, event count reads: %.2f per interrupt\n",
+           (unsigned long long)(elapsed / INTERRUPTS),
+           (unsigned long long)(reactor_cpu_ns / INTERRUPTS),
+           (double)(INTERRUPTS - unread) / INTERRUPTS);
+
+    cap_reactor_release(&reactor);
+    rw_close(&be);
+
+    if(results != INTERRUPTS || last_count != count)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file bench_ring.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Throughput of capture result ring (producer and consumer threads)
+ * @version 0.1
+ * @date 2024-10-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "cap_ring.h"
+#include "bench.h"
+
+#define RESULTS     (1 << 24)
+#define BATCH       1024
+
+static struct cap_ring ring;
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    for(uint32_t i = 0; i < RESULTS; i++) {
+        struct cap_result_raw raw = {.on_cycles = i, .off_cycles = i >> 16};
+        // full ring: let consumer run (single core hosts)
+        while(!cap_ring_push(&ring, &raw))
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    static struct cap_result_raw out[BATCH];
+
+    // single thread: cost of push / pop alone
+    cap_ring_init(&ring);
+    uint64_t start = bench_now_ns();
+    for(uint32_t i = 0; i < RESULTS; i += BATCH) {
+        for(uint32_t j = 0; j < BATCH; j++) {
+            struct cap_result_raw raw = {.on_cycles = j};
+            cap_ring_push(&ring, &raw);
+        }
+        BENCH_KEEP(cap_ring_pop(&ring, out, BATCH));
+    }
+    uint64_t single_ns = bench_now_ns() - start;
+
+    cap_ring_init(&ring);
+    uint64_t popped = 0;
+    uint64_t calls = 0;
+    uint32_t expect = 0;
+
+    pthread_t th;
+    start = bench_now_ns();
+    if(pthread_create(&th, NULL, producer, NULL)) {
+        perror("pthread_create");
+        return 1;
+    }
+
+    while(popped < RESULTS) {
+        uint32_t n = cap_ring_pop(&ring, out, BATCH);
+        for(uint32_t i = 0; i < n; i++, expect++) {
+            if(out[i].on_cycles != (uint16_t)expect || out[i].off_cycles != (uint16_t)(expect >> 16)) {
+                fprintf(stderr, "out of order result at %u\n", expect);
+                return 1;
+            }
+        }
+        popped += n;
+        calls++;
+        if(!n)
+            sched_yield();
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    pthread_join(th, NULL);
+
+    printf("results:   %llu (%llu pop calls, %.1f per call)\n",
+           (unsigned long long)popped, (unsigned long long)calls, (double)popped / calls);
+    printf("overflow:  %llu (producer retried)\n", (unsigned long long)cap_ring_overflow(&ring));
+    printf("single:    %10.0f results/s (push + batch pop, one thread)\n", RESULTS * 1e9 / single_ns);
+    printf("threads:   %10.0f results/s (producer and consumer threads)\n", popped * 1e9 / elapsed);
+
+    return 0;
+}
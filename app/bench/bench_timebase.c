@@ -0,0 +1,88 @@
+/**
+ * @file bench_timebase.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Benchmark of fixed point timebase against 64bit division path
+ * @version 0.1
+ * @date 2024-10-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdio.h>
+
+#include "soc.h"
+#include "timebase.h"
+#include "bench.h"
+
+#define SAMPLES     (1 << 16)
+#define ROUNDS      200
+
+/**
+ * @brief Conversion as it was done before timebase (truncated clock period)
+ *
+ */
+static uint64_t div_cycles_to_ns(struct pwm_clk clk, uint8_t pre, uint32_t cycles)
+{
+    uint64_t clk_freq = (clk.src == APB0 ? APB0_FREQ : HOSC_FREQ);
+    uint64_t period_ns = (NSEC_IN_SEC / clk_freq) * (1 + pre) * (1 << clk.div);
+    return cycles * period_ns;
+}
+
+static uint64_t div_cycles_to_hz(struct pwm_clk clk, uint8_t pre, uint32_t cycles)
+{
+    uint64_t clk_freq = (clk.src == APB0 ? APB0_FREQ : HOSC_FREQ);
+    uint64_t period_ns = (NSEC_IN_SEC / clk_freq) * (1 + pre) * (1 << clk.div);
+    return NSEC_IN_SEC / (period_ns * cycles);
+}
+
+static uint32_t cycles[SAMPLES];
+
+int main()
+{
+    struct pwm_clk clk = {.src = HOSC, .div = DIV_1};
+    uint8_t pre = 0;
+
+    struct pwm_timebase tb;
+    timebase_init(&tb, clk, pre);
+
+    for(uint32_t i = 0; i < SAMPLES; i++)
+        cycles[i] = (i * 2654435761u) & 0xFFFF;
+
+    // accuracy against exact value (cycles * 125 / 3 nS)
+    double div_err = 0, tb_err = 0;
+    for(uint32_t i = 0; i < SAMPLES; i++) {
+        double exact = cycles[i] * 125.0 / 3.0;
+        double e1 = (double)div_cycles_to_ns(clk, pre, cycles[i]) - exact;
+        double e2 = (double)tb_cycles_to_ns(&tb, cycles[i]) - exact;
+        if(e1 < 0) e1 = -e1;
+        if(e2 < 0) e2 = -e2;
+        if(e1 > div_err) div_err = e1;
+        if(e2 > tb_err) tb_err = e2;
+    }
+
+    uint64_t sum = 0;
+    uint64_t start = bench_now_ns();
+    for(uint32_t r = 0; r < ROUNDS; r++)
+        for(uint32_t i = 0; i < SAMPLES; i++) {
+            sum += div_cycles_to_ns(clk, pre, cycles[i]);
+            sum += div_cycles_to_hz(clk, pre, cycles[i] | 1);
+        }
+    uint64_t div_ns = bench_now_ns() - start;
+    BENCH_KEEP(sum);
+
+    sum = 0;
+    start = bench_now_ns();
+    for(uint32_t r = 0; r < ROUNDS; r++)
+        for(uint32_t i = 0; i < SAMPLES; i++) {
+            sum += tb_cycles_to_ns(&tb, cycles[i]);
+            sum += tb_cycles_to_hz(&tb, cycles[i] | 1);
+        }
+    uint64_t tb_ns = bench_now_ns() - start;
+    BENCH_KEEP(sum);
+
+    double n = (double)SAMPLES * ROUNDS;
+    printf("division: %.2f nS/conversion, max error %.2f nS\n", div_ns / n, div_err);
+    printf("timebase: %.2f nS/conversion, max error %.3f nS\n", tb_ns / n, tb_err);
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+/**
+ * @file backend.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief PWM register window backends (UIO, /dev/mem, RAM, file)
+ * @version 0.1
+ * @date 2024-10-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Type of register window backend
+ *
+ */
+enum rw_backend_type {
+    RW_BACKEND_UIO =    0x00,   // UIO device node (e.g /dev/uio0)
+    RW_BACKEND_DEVMEM = 0x01,   // Physical memory through /dev/mem
+    RW_BACKEND_RAM =    0x02,   // Anonymous memory (no hardware)
+    RW_BACKEND_FILE =   0x03    // Memory mapped register image file
+};
+
+/**
+ * @brief Mapped PWM register window
+ * @note Every backend maps register window into process memory, so
+ *       rw.h accessors dereference base address directly (no dispatch).
+ *       RAM and file backends let whole library run on host without T113
+ */
+struct rw_backend {
+    enum rw_backend_type type;
+    int fd;                     // file descriptor (-1 for RAM backend)
+    void *map;                  // start of mapping
+    size_t map_size;            // size of mapping
+    void *base;                 // base address of PWM peripheral
+};
+
+/**
+ * @brief Map PWM register window through UIO device
+ *
+ * @param be Backend to be filled
+ * @param dev UIO device node (e.g /dev/uio0)
+ * @return int32_t 0 on success
+ * @note UIO device keeps page offset of PWM_BASE_ADDR (check driver).
+ *       Descriptor is bound to window as its interrupt source (check irq.h)
+ */
+int32_t rw_open_uio(struct rw_backend *be, const char *dev);
+
+/**
+ * @brief Map PWM register window through /dev/mem
+ *
+ * @param be Backend to be filled
+ * @param phys Physical address of PWM peripheral (e.g PWM_BASE_ADDR)
+ * @return int32_t 0 on success
+ */
+int32_t rw_open_devmem(struct rw_backend *be, uint64_t phys);
+
+/**
+ * @brief Allocate zero filled register window in RAM
+ *
+ * @param be Backend to be filled
+ * @return int32_t 0 on success
+ */
+int32_t rw_open_ram(struct rw_backend *be);
+
+/**
+ * @brief Map register image file as register window
+ *
+ * @param be Backend to be filled
+ * @param path Image file path. It's created (zero filled) if not exist
+ * @return int32_t 0 on success
+ */
+int32_t rw_open_file(struct rw_backend *be, const char *path);
+
+/**
+ * @brief Unmap register window and close backend
+ *
+ * @param be Backend
+ */
+void rw_close(struct rw_backend *be);
+
+#endif // BACKEND_H
@@ -0,0 +1,57 @@
+#ifndef CAP_CONVERT_H
+#define CAP_CONVERT_H
+/**
+ * @file cap_convert.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Batch conversion of raw capture results (NEON / SSE2 / scalar)
+ * @version 0.1
+ * @date 2024-10-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+
+#include "config.h"
+#include "timebase.h"
+
+/**
+ * @brief Converted capture result
+ *
+ */
+struct cap_sample {
+    uint64_t on_ns;
+    uint64_t off_ns;
+    uint32_t freq_hz;           // 0 if period is 0
+    uint16_t duty;              // on / period in permille (rounded)
+};
+
+/**
+ * @brief Convert array of raw capture results with single timebase
+ *
+ * @param tb Timebase of channel (check timebase_get())
+ * @param raw Raw capture results
+ * @param out Converted results
+ * @param n Number of results
+ * @note nS values are bit identical to tb_cycles_to_ns() / result_to_ns(),
+ *       frequency to tb_cycles_to_hz() of on + off cycles.
+ *       Uses NEON (ARMv7 -mfpu=neon) or SSE2 when compiler enables them
+ */
+void cap_convert(const struct pwm_timebase *tb, const struct cap_result_raw *raw,
+                 struct cap_sample *out, uint32_t n);
+
+/**
+ * @brief Reference scalar implementation of cap_convert()
+ *
+ */
+void cap_convert_scalar(const struct pwm_timebase *tb, const struct cap_result_raw *raw,
+                        struct cap_sample *out, uint32_t n);
+
+/**
+ * @brief Name of kernel selected at build time
+ *
+ * @return const char* "neon", "sse2" or "scalar"
+ */
+const char *cap_convert_isa(void);
+
+#endif // CAP_CONVERT_H
@@ -0,0 +1,94 @@
+#ifndef CAP_FREQ_H
+#define CAP_FREQ_H
+/**
+ * @file cap_freq.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Frequency counter on capture results (reciprocal / gated)
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+#include "timebase.h"
+
+/**
+ * @brief Counting method
+ *
+ */
+enum cap_freq_mode {
+    CAP_FREQ_RECIPROCAL =   0x00,   // sum of locked periods in counter cycles
+    CAP_FREQ_GATED =        0x01,   // number of periods per wall clock time
+    CAP_FREQ_AUTO =         0x02    // gated while lock registers saturate and
+                                    // delivery is guaranteed (irq_gap)
+};
+
+/**
+ * @brief Frequency of one gate window
+ *
+ */
+struct cap_freq_result {
+    uint64_t freq_mhz;          // frequency in mHz
+    uint64_t resolution_mhz;    // one count of method in mHz
+    uint64_t gate_ns;           // length of window
+    uint32_t periods;           // periods accounted in window
+    enum cap_freq_mode mode;    // method used for this window
+};
+
+/**
+ * @brief Frequency counter of one capture channel
+ * @note Reciprocal: resolution is one counter cycle over the whole gate
+ *       instead of one cycle per period. Gated: counts delivered results per
+ *       wall clock time (check struct cap_event), so every period must be
+ *       delivered. Window is dropped once UIO event count of results jumps by
+ *       more than irq_gap (or is unknown), interrupts were then missed
+ */
+struct cap_freq {
+    struct pwm_timebase tb;     // exact src_hz and div, tick_hz is rounded
+    enum cap_freq_mode mode;
+    uint64_t gate_ns;
+    uint64_t start_ns;          // timestamp of first result of window
+    uint64_t cycles;            // sum of on + off cycles
+    uint32_t periods;
+    uint32_t saturated;         // results with a saturated edge
+    uint32_t irq_gap;           // max UIO events between two results, 0: not guaranteed
+    uint32_t irq_count;         // UIO event count of previous result
+    bool lost;                  // window missed results
+    uint32_t dropped;           // gated windows dropped because of lost results
+};
+
+/**
+ * @brief Initialize frequency counter
+ *
+ * @param f Counter
+ * @param tb Timebase of channel (check timebase_get())
+ * @param mode Counting method
+ * @param gate_ms Length of gate window in mS
+ * @param irq_gap Maximum UIO event count between two consecutive results of
+ *        channel when none is lost (e.g 2 per channel served on the shared
+ *        line), 0 if caller can't guarantee every period is delivered
+ * @return int32_t 0 on success, -EINVAL if gated mode has no irq_gap
+ * @note Call it again after counter clock of channel is changed. Without
+ *       irq_gap auto mode drops saturated windows instead of gating them
+ */
+int32_t cap_freq_init(struct cap_freq *f, const struct pwm_timebase *tb,
+                      enum cap_freq_mode mode, uint32_t gate_ms, uint32_t irq_gap);
+
+/**
+ * @brief Account capture result, close gate window once it's elapsed
+ *
+ * @param f Counter
+ * @param ev Capture result with timestamp
+ * @param res Result of closed window
+ * @return int32_t 1 if window is closed and res is filled, 0 otherwise (also
+ *         when gated window is dropped, check dropped)
+ * @note Constant time, no division unless window is closed
+ */
+int32_t cap_freq_push(struct cap_freq *f, const struct cap_event *ev,
+                      struct cap_freq_result *res);
+
+#endif // CAP_FREQ_H
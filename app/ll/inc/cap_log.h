@@ -0,0 +1,158 @@
+#ifndef CAP_LOG_H
+#define CAP_LOG_H
+/**
+ * @file cap_log.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Memory mapped binary log of capture results
+ * @version 0.1
+ * @date 2024-10-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * @note File layout (little endian, offsets in header):
+ *       header | raw[capacity] | ts_ns[capacity] | irq_count[capacity]
+ *       Records are split into arrays, so raw results can be passed to
+ *       cap_convert() and cap_stats_push_batch() straight from the mapping
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "clk.h"
+#include "config.h"
+#include "timebase.h"
+
+#define CAP_LOG_MAGIC       0x474C5043  // "CPLG"
+#define CAP_LOG_VERSION     1
+
+/**
+ * @brief On-disk header of capture log (64 bytes)
+ *
+ */
+struct cap_log_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint8_t ch;                 // capture channel
+    uint8_t src;                // enum clk_src
+    uint8_t div;                // enum clk_div
+    uint8_t pre;                // pre-scaler
+    uint32_t tick_hz;           // counter clock (informative)
+    uint64_t capacity;          // preallocated records
+    uint64_t count;             // committed records, updated by writer
+    uint64_t raw_off;           // offset of struct cap_result_raw array
+    uint64_t ts_off;            // offset of uint64_t CLOCK_MONOTONIC array
+    uint64_t irq_off;           // offset of uint32_t UIO event count array
+    uint32_t reserved[2];
+};
+
+_Static_assert(sizeof(struct cap_log_header) == 64, "cap_log_header must be 64 bytes");
+
+/**
+ * @brief Mapped capture log (writer or reader)
+ *
+ */
+struct cap_log {
+    int fd;
+    void *map;
+    size_t map_size;
+    bool writer;
+    struct cap_log_header *hdr;
+    struct cap_result_raw *raw;
+    uint64_t *ts_ns;
+    uint32_t *irq_count;
+    uint64_t count;             // writer: next record index
+    uint64_t dropped;           // writer: records dropped because log was full
+};
+
+/**
+ * @brief Create log file, preallocate and map it for writing
+ *
+ * @param log Log to be initialized
+ * @param path File path (truncated if exist)
+ * @param capacity Number of records (whole file must fit in address space)
+ * @param ch Capture channel
+ * @param clk Clock configuration of channel
+ * @param pre Pre-scaler of channel
+ * @return int32_t 0 on success
+ * @note Whole file is allocated and pre-faulted here, so appending never
+ *       blocks on disk allocation
+ */
+int32_t cap_log_create(struct cap_log *log, const char *path, uint64_t capacity,
+                       uint8_t ch, struct pwm_clk clk, uint8_t pre);
+
+/**
+ * @brief Append capture result (writer only)
+ *
+ * @param log Log
+ * @param ev Capture result with timestamp (check cap_wait_event())
+ * @return int32_t 0 on success, -ENOSPC if log is full (result is counted as dropped)
+ * @note Plain stores into mapping, safe to call from capture callback
+ */
+static inline int32_t cap_log_append(struct cap_log *log, const struct cap_event *ev)
+{
+    uint64_t i = log->count;
+    if(i == log->hdr->capacity) {
+        log->dropped++;
+        return -ENOSPC;
+    }
+
+    log->raw[i] = ev->raw;
+    log->ts_ns[i] = ev->ts_ns;
+    log->irq_count[i] = ev->irq_count;
+    log->count = i + 1;
+
+    // record is visible to live readers before count
+    __atomic_store_n(&log->hdr->count, i + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/**
+ * @brief Schedule write back of mapping (doesn't wait)
+ *
+ * @param log Log
+ * @return int32_t 0 on success
+ */
+int32_t cap_log_flush(struct cap_log *log);
+
+/**
+ * @brief Map existing log file for reading (zero copy)
+ *
+ * @param log Log to be initialized
+ * @param path File path
+ * @return int32_t 0 on success, -EINVAL if file is not valid capture log
+ * @note log->raw, log->ts_ns and log->irq_count point into mapping
+ */
+int32_t cap_log_open(struct cap_log *log, const char *path);
+
+/**
+ * @brief Number of committed records (also while writer is running)
+ *
+ * @param log Log
+ * @return uint64_t Number of records
+ */
+static inline uint64_t cap_log_count(const struct cap_log *log)
+{
+    return __atomic_load_n(&log->hdr->count, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Timebase of logged channel (check cap_convert(), cap_stats_snapshot())
+ *
+ * @param log Log
+ * @param tb Timebase to be filled
+ * @return int32_t 0 on success
+ */
+int32_t cap_log_timebase(const struct cap_log *log, struct pwm_timebase *tb);
+
+/**
+ * @brief Flush (writer) and unmap log
+ *
+ * @param log Log
+ * @return int32_t 0 on success
+ */
+int32_t cap_log_close(struct cap_log *log);
+
+#endif // CAP_LOG_H
@@ -0,0 +1,67 @@
+#ifndef CAP_RANGE_H
+#define CAP_RANGE_H
+/**
+ * @file cap_range.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Auto-ranging capture (retune divider / pre-scaler to input signal)
+ * @version 0.1
+ * @date 2024-10-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "clk.h"
+#include "config.h"
+
+#define CAP_RANGE_HIGH      0xF000  // slow down counter clock above this count
+#define CAP_RANGE_LOW       0x0800  // speed up counter clock below this count
+#define CAP_RANGE_TARGET    0x4000  // count of longer edge after retune
+#define CAP_RANGE_PROBE     16      // slow down factor when count may have wrapped
+
+/**
+ * @brief Auto-ranging state of capture channel
+ * @note Counter clock is src / total, total = div * (pre + 1) [1, 65536].
+ *       16bit lock registers wrap on slow pulses, so small count is either
+ *       fast signal or wrapped slow one. Small count is only trusted once
+ *       counter clock was slowed down by CAP_RANGE_PROBE and count scaled
+ *       along (probe), otherwise clock is slowed down first
+ */
+struct cap_range {
+    void *base;
+    uint8_t ch;
+    enum clk_src src;
+    uint32_t total;             // current division of source clock
+    uint32_t retunes;           // number of clock changes
+    uint32_t probe;             // expected count after probe, 0: no probe pending
+};
+
+/**
+ * @brief Configure capture channel and start auto-ranging
+ *
+ * @param r Auto-ranging state to be initialized
+ * @param p Pointer to PWM base address
+ * @param ch PWM channel (0 to 7)
+ * @param config Initial capture configuration (check set_cap_config())
+ * @return int32_t 0 on success
+ */
+int32_t cap_range_init(struct cap_range *r, void *p, uint8_t ch,
+                       const struct cap_config *config);
+
+/**
+ * @brief Check capture result and retune counter clock if needed
+ *
+ * @param r Auto-ranging state
+ * @param raw Capture result of channel
+ * @return int32_t 0 if result is in range, 1 if clock was retuned (result
+ *         is valid but pending edges are dropped, small counts are not
+ *         valid until probe confirms them), negative on error
+ *         (e.g -EBUSY if running partner channel can't follow)
+ * @note Partner channel (ch ^ 1) keeps its counter clock (check clk_arbitrate())
+ *       and timebase of channel is updated, so result_to_ns() stays exact
+ */
+int32_t cap_range_update(struct cap_range *r, const struct cap_result_raw *raw);
+
+#endif // CAP_RANGE_H
@@ -0,0 +1,148 @@
+#ifndef CAP_REACTOR_H
+#define CAP_REACTOR_H
+/**
+ * @file cap_reactor.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Single thread capture of all channels on shared PWM interrupt
+ * @version 0.1
+ * @date 2024-10-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "soc.h"
+#include "config.h"
+
+/**
+ * @brief Called from cap_reactor_run() once both edges of channel are locked
+ *
+ */
+typedef void (*cap_reactor_cb)(const struct cap_event *ev, void *arg);
+
+/**
+ * @brief Capture channel served by reactor
+ *
+ */
+struct cap_reactor_ch {
+    cap_reactor_cb cb;
+    void *arg;
+    struct cap_result_raw raw;  // edges locked so far
+    uint8_t locked;             // CRISx / CFISx bits already collected
+    uint64_t overrun;           // edges which may have been lost
+};
+
+/**
+ * @brief Capture reactor
+ * @note Owns UIO descriptor of register window. Each interrupt costs two
+ *       syscalls: write() which re-arms the line (irqcontrol) and
+ *       epoll_wait(), no more with any number of channels. UIO re-arms only
+ *       on write() and reports only through poll() / read(), so one syscall
+ *       isn't possible. Driver masks the line per interrupt, so wakeups are
+ *       counted and event count is read every 64 wakeups (every wakeup
+ *       without irqcontrol).
+ *       One CISR read per interrupt, handled CISR and CCR lock flags are
+ *       cleared in one transaction (same state as clear_cap_irq()).
+ *       Overrun of channel is counted when an edge is locked again before
+ *       its pair completes. Interrupts of the shared line coalesced between
+ *       dispatches (UIO event count jumps by more than one, e.g taken by
+ *       another waiter) are counted once per reactor when count is read,
+ *       and only if driver masks the line (irqcontrol)
+ */
+struct cap_reactor {
+    void *base;
+    int uio_fd;                 // UIO descriptor of register window
+    int epoll_fd;
+    int stop_fd;                // eventfd, written by cap_reactor_stop()
+    bool unmask;                // driver supports irqcontrol
+    uint32_t irq_count;         // UIO event count of last dispatch
+    uint32_t wakeups;           // wakeups since cap_reactor_run()
+    bool counted;               // irq_count is valid baseline
+    uint64_t irq_overrun;       // interrupts coalesced between dispatches
+    uint8_t mask;               // served channels
+    struct cap_reactor_ch ch[PWM_CHANNEL];
+};
+
+/**
+ * @brief Create reactor on PWM register window
+ *
+ * @param r Reactor to be initialized
+ * @param base Base address of PWM peripheral (bound to UIO descriptor)
+ * @return int32_t 0 on success, -ENODEV if window has no interrupt descriptor
+ */
+int32_t cap_reactor_init(struct cap_reactor *r, void *base);
+
+/**
+ * @brief Serve capture channel
+ *
+ * @param r Reactor
+ * @param ch Channel index [0, 7], must be configured by set_cap_config()
+ * @param cb Callback of each on/off result
+ * @param arg Callback argument
+ * @return int32_t 0 on success
+ * @note Call it before cap_reactor_run() or from callbacks (same thread)
+ */
+int32_t cap_reactor_add(struct cap_reactor *r, uint8_t ch, cap_reactor_cb cb, void *arg);
+
+/**
+ * @brief Stop serving capture channel
+ *
+ * @param r Reactor
+ * @param ch Channel index [0, 7]
+ * @return int32_t 0 on success
+ */
+int32_t cap_reactor_remove(struct cap_reactor *r, uint8_t ch);
+
+/**
+ * @brief Number of edges of channel which may have been lost
+ *
+ * @param r Reactor
+ * @param ch Channel index [0, 7]
+ * @return uint64_t Overrun counter
+ */
+static inline uint64_t cap_reactor_overrun(const struct cap_reactor *r, uint8_t ch)
+{
+    return (ch < PWM_CHANNEL) ? r->ch[ch].overrun : 0;
+}
+
+/**
+ * @brief Number of interrupts of shared line coalesced between dispatches
+ *
+ * @param r Reactor
+ * @return uint64_t Overrun counter (always 0 if driver doesn't mask the line)
+ * @note Covers whole line (PWM cycle and capture interrupts of all channels)
+ */
+static inline uint64_t cap_reactor_irq_overrun(const struct cap_reactor *r)
+{
+    return r->irq_overrun;
+}
+
+/**
+ * @brief Dispatch capture interrupts until cap_reactor_stop()
+ *
+ * @param r Reactor
+ * @return int32_t 0 when stopped, negative errno on failure
+ * @note Register accessors are shared with other threads, so no shadow copy
+ *       may be attached to any window while it runs (check rw_shadow_attach())
+ */
+int32_t cap_reactor_run(struct cap_reactor *r);
+
+/**
+ * @brief Ask cap_reactor_run() to return
+ *
+ * @param r Reactor
+ * @return int32_t 0 on success
+ * @note Safe to call from any thread or signal handler
+ */
+int32_t cap_reactor_stop(struct cap_reactor *r);
+
+/**
+ * @brief Disable capture interrupts of served channels and free reactor
+ *
+ * @param r Reactor
+ */
+void cap_reactor_release(struct cap_reactor *r);
+
+#endif // CAP_REACTOR_H
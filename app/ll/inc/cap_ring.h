@@ -0,0 +1,99 @@
+#ifndef CAP_RING_H
+#define CAP_RING_H
+/**
+ * @file cap_ring.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Lock-free single producer / single consumer ring of capture results
+ * @version 0.1
+ * @date 2024-10-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+
+#include "config.h"
+
+#define CAP_RING_SIZE       4096    // must be power of 2
+#define CAP_RING_LINE       64      // cache line size
+
+_Static_assert(!(CAP_RING_SIZE & (CAP_RING_SIZE - 1)), "CAP_RING_SIZE must be power of 2");
+
+/**
+ * @brief Ring of capture results of one channel
+ * @note Producer (e.g capture callback) and consumer indexes live in separate
+ *       cache lines. Each side keeps a private copy of the other index, so
+ *       shared index is read only when ring looks full / empty.
+ *       Indexes are free running, slot is (index & (CAP_RING_SIZE - 1))
+ */
+struct cap_ring {
+    // producer side
+    alignas(CAP_RING_LINE) _Atomic uint32_t head;
+    uint32_t tail_cache;
+    _Atomic uint64_t overflow;  // results dropped because ring was full
+
+    // consumer side
+    alignas(CAP_RING_LINE) _Atomic uint32_t tail;
+    uint32_t head_cache;
+
+    alignas(CAP_RING_LINE) struct cap_result_raw buf[CAP_RING_SIZE];
+};
+
+/**
+ * @brief Initialize empty ring
+ *
+ * @param r Ring
+ */
+void cap_ring_init(struct cap_ring *r);
+
+/**
+ * @brief Push single result (producer only)
+ *
+ * @param r Ring
+ * @param raw Capture result
+ * @return bool false if ring is full (result is dropped and counted)
+ * @note Never blocks nor allocates
+ */
+static inline bool cap_ring_push(struct cap_ring *r, const struct cap_result_raw *raw)
+{
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    if(head - r->tail_cache == CAP_RING_SIZE) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if(head - r->tail_cache == CAP_RING_SIZE) {
+            atomic_fetch_add_explicit(&r->overflow, 1, memory_order_relaxed);
+            return false;
+        }
+    }
+
+    r->buf[head & (CAP_RING_SIZE - 1)] = *raw;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief Pop up to max results in one call (consumer only)
+ *
+ * @param r Ring
+ * @param out Results, oldest first
+ * @param max Size of out
+ * @return uint32_t Number of results copied into out
+ */
+uint32_t cap_ring_pop(struct cap_ring *r, struct cap_result_raw *out, uint32_t max);
+
+/**
+ * @brief Number of results dropped because ring was full
+ *
+ * @param r Ring
+ * @return uint64_t Overflow counter
+ */
+static inline uint64_t cap_ring_overflow(struct cap_ring *r)
+{
+    return atomic_load_explicit(&r->overflow, memory_order_relaxed);
+}
+
+#endif // CAP_RING_H
@@ -0,0 +1,128 @@
+#ifndef CAP_STATS_H
+#define CAP_STATS_H
+/**
+ * @file cap_stats.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Streaming statistics of captured pulses (constant memory per channel)
+ * @version 0.1
+ * @date 2024-10-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+
+#include "config.h"
+#include "timebase.h"
+
+// 4 bins per octave of 17 bit period (on + off cycles)
+#define CAP_STATS_SUB_BITS  2
+#define CAP_STATS_BINS      64
+
+/**
+ * @brief Running statistics of single quantity (in counter cycles)
+ * @note Welford's algorithm, numerically stable for long runs
+ */
+struct cap_stats_acc {
+    double mean;
+    double m2;              // sum of squared differences from mean
+    double ewma;            // exponentially weighted moving average
+    uint32_t min;
+    uint32_t max;
+};
+
+/**
+ * @brief Statistics of one capture channel
+ *
+ */
+struct cap_stats {
+    uint64_t count;
+    double alpha;           // EWMA weight of new sample (0, 1]
+    struct cap_stats_acc on;
+    struct cap_stats_acc off;
+    struct cap_stats_acc period;
+    uint32_t hist_on[CAP_STATS_BINS];
+    uint32_t hist_off[CAP_STATS_BINS];
+};
+
+/**
+ * @brief Summary of single quantity in nS
+ *
+ */
+struct cap_stats_value {
+    double mean_ns;
+    double stddev_ns;
+    double ewma_ns;
+    double min_ns;
+    double max_ns;
+};
+
+/**
+ * @brief Snapshot of channel statistics
+ *
+ */
+struct cap_stats_snapshot {
+    uint64_t count;
+    struct cap_stats_value on;
+    struct cap_stats_value off;
+    struct cap_stats_value period;  // stddev of period is jitter
+    double freq_hz;                 // from mean period
+    double duty;                    // mean on / mean period (percent)
+};
+
+/**
+ * @brief Initialize (or reset) statistics
+ *
+ * @param s Statistics
+ * @param alpha EWMA weight of new sample (0, 1], e.g 1/16
+ * @return int32_t 0 on success
+ */
+int32_t cap_stats_init(struct cap_stats *s, double alpha);
+
+/**
+ * @brief Histogram bin of width in counter cycles
+ *
+ * @param cycles Width in counter cycles
+ * @return uint8_t Bin index [0, CAP_STATS_BINS - 1]
+ * @note Bins are exact below 4 cycles, then 4 bins per power of 2
+ */
+uint8_t cap_stats_bin(uint32_t cycles);
+
+/**
+ * @brief Smallest width (in counter cycles) which falls into bin
+ *
+ * @param bin Bin index [0, CAP_STATS_BINS - 1]
+ * @return uint32_t Lower bound of bin
+ */
+uint32_t cap_stats_bin_low(uint8_t bin);
+
+/**
+ * @brief Account single capture result
+ *
+ * @param s Statistics
+ * @param raw Capture result
+ */
+void cap_stats_push(struct cap_stats *s, const struct cap_result_raw *raw);
+
+/**
+ * @brief Account array of capture results (e.g drained from cap_ring)
+ *
+ * @param s Statistics
+ * @param raw Capture results
+ * @param n Number of results
+ */
+void cap_stats_push_batch(struct cap_stats *s, const struct cap_result_raw *raw, uint32_t n);
+
+/**
+ * @brief Report statistics in nS / Hz
+ *
+ * @param s Statistics
+ * @param tb Timebase of channel (check timebase_get())
+ * @param snap Snapshot to be filled
+ * @return int32_t 0 on success
+ * @note No register access, histograms stay in counter cycles (check s->hist_on)
+ */
+int32_t cap_stats_snapshot(const struct cap_stats *s, const struct pwm_timebase *tb,
+                           struct cap_stats_snapshot *snap);
+
+#endif // CAP_STATS_H
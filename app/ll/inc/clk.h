@@ -49,6 +49,21 @@ struct pwm_clk {
     enum clk_div div;
 };
 
+/**
+ * @brief Clock configuration of channel pair which satisfies both channels
+ *
+ */
+struct clk_plan {
+    struct pwm_clk clk;         // shared source and divider (PCCRxy)
+    uint8_t pre;                // pre-scaler of requested channel
+    bool pccr_changed;          // PCCRxy must be written
+    bool partner;               // partner channel (ch ^ 1) is running
+    bool partner_changed;       // partner pre-scaler must be written
+    uint8_t partner_pre;        // new pre-scaler of partner channel
+};
+
+struct rw_txn;
+
 /**
  * @brief Check source and divider range
  * 
@@ -75,9 +90,48 @@ int32_t clk_gate(void *base, uint8_t ch, bool pass);
  * @param clk Clock configuration (Source and Divider)
  * @return int32_t 0 on success
  * @note It's shared between (c) and (ch + 1). Please check reference manual
+ *       Register is not written if value is not changed.
+ *       Use clk_pair_config() in order to keep partner channel running
  */
 int32_t clk_config(void *base, uint8_t ch, struct pwm_clk clk);
 
+/**
+ * @brief Find shared clock configuration for channel pair (ch, ch ^ 1)
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @param clk Requested clock configuration
+ * @param pre Requested pre scaler
+ * @param plan Configuration which keeps counter clock of both channels
+ * @return int32_t 0 on success, -EBUSY if running partner can't be kept
+ * @note Counter clock of channel is src / (div * (pre + 1)). If partner is
+ *       running (PWM or capture enabled), divider is chosen so that both
+ *       channels keep their counter clock and difference is moved into
+ *       per channel pre-scalers. Current divider is preferred.
+ */
+int32_t clk_arbitrate(void *base, uint8_t ch, struct pwm_clk clk, uint8_t pre,
+                      struct clk_plan *plan);
+
+/**
+ * @brief Stage clock plan (PCCRxy and pre-scalers) into transaction
+ *
+ * @param txn Register transaction
+ * @param ch Channel index [0, 7]
+ * @param plan Result of clk_arbitrate()
+ */
+void clk_plan_stage(struct rw_txn *txn, uint8_t ch, const struct clk_plan *plan);
+
+/**
+ * @brief Configure clock and pre-scaler without breaking partner channel
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @param clk Clock configuration (Source and Divider)
+ * @param pre Clock pre scaler
+ * @return int32_t 0 on success, -EBUSY if partner channel can't be kept
+ */
+int32_t clk_pair_config(void *base, uint8_t ch, struct pwm_clk clk, uint8_t pre);
+
 /**
  * @brief Report current clock configuration
  * 
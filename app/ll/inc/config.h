@@ -50,6 +50,18 @@ struct cap_result_raw
     uint16_t off_cycles;
 };
 
+/**
+ * @brief Capture result with time of delivery
+ *
+ */
+struct cap_event
+{
+    struct cap_result_raw raw;
+    uint8_t ch;
+    uint32_t irq_count;         // UIO event count of interrupt which completed it (0 if unknown)
+    uint64_t ts_ns;             // CLOCK_MONOTONIC when lock registers were read
+};
+
 /**
  * @brief Capture result in nano seconds
  * 
@@ -73,8 +85,9 @@ int32_t pwm_min_max_period(uint64_t *max_ns, uint64_t *min_ns);
  * @brief PWM pulse counter clock period (which increment PPCNTR)
  * 
  * @param config Pointer to PWM configuration
- * @param period_ns Clock period in nS
+ * @param period_ns Clock period in nS (rounded)
  * @return int32_t 0 on success
+ * @note Use timebase.h for sub nS accurate conversions
  */
 int32_t pwm_clk_period(const struct pwm_config *config, uint64_t *period_ns);
 
@@ -95,7 +108,13 @@ int32_t get_pwm_freq(void *p, uint8_t ch, uint64_t *freq_hz);
  * @param period_ns PWM period in nS
  * @param duty_cycle PWM duty cycle in percent (0 to 100)
  * @param config Pointer to PWM configuration to be filled
- * @return 0 on success
+ * @return 0 on success, -ERANGE if period can't be generated
+ * @note Every source, divider and pre-scaler is searched. Configuration with
+ *       minimum period error is selected and in case of equal error, the one
+ *       with maximum duty cycle resolution (entire cycles).
+ *       Divider segments which can't beat best error are skipped and
+ *       pre-scalers are tested with reciprocal table (no division per divider).
+ *       Only clk, pre and period are filled (state and en are untouched)
  */
 int32_t pwm_calc(uint64_t period_ns, uint8_t duty_cycle, struct pwm_config *config);
 
@@ -115,10 +134,26 @@ int32_t get_pwm_config(void *p, uint8_t ch, struct pwm_config *config);
  * @param p Pointer to PWM base address
  * @param ch PWM channel (0 to 7)
  * @param config Pointer to configuration
- * @return int32_t 0 on success
+ * @return int32_t 0 on success, -ETIMEDOUT if disabling didn't see end of
+ *         cycle (channel is disabled and gated anyway, check pwm_en())
  */
 int32_t set_pwm_config(void *p, uint8_t ch, const struct pwm_config *config);
 
+/**
+ * @brief Configure channel pair (ch, ch + 1) as complementary output with
+ *        hardware dead zone insertion (e.g half-bridge)
+ *
+ * @param p Pointer to PWM base address
+ * @param ch Even PWM channel (0, 2, 4, 6)
+ * @param config Configuration of ch, ch + 1 outputs its complement
+ * @param dead_ns Dead time in nS (converted into PWMxy clock cycles)
+ * @return int32_t 0 on success, -ERANGE if dead time doesn't fit, -ETIMEDOUT
+ *         if disabling didn't see end of cycle (pair is disabled anyway)
+ * @note Duty cycle of pair is single PPR write of ch (e.g pwm_duty_frac())
+ */
+int32_t set_pwm_pair_config(void *p, uint8_t ch, const struct pwm_config *config,
+                            uint32_t dead_ns);
+
 /**
  * @brief Set the pwm duty cycle (in percentage)
  * 
@@ -149,6 +184,39 @@ int32_t set_cap_config(void *p, uint8_t ch, const struct cap_config *config);
  */
 int32_t cap_blocking(void *p, uint8_t ch, struct cap_result_raw *result);
 
+/**
+ * @brief Capture on/off cycles of input pulse on capture interrupt
+ *
+ * @param p Pointer to PWM base address
+ * @param ch PWM channel (0 to 7)
+ * @param result Number of cycles of on and off
+ * @param timeout_ms Maximum wait time in mS
+ * @param cancel_fd Wait is cancelled once it's readable (e.g eventfd), -1 for none
+ * @return int32_t 0 on success, -ETIMEDOUT, -ECANCELED or -ENODEV if window
+ *         has no interrupt descriptor (check irq.h)
+ * @note Sleeps on UIO descriptor instead of polling, result is available as
+ *       soon as both edges are locked. Edges locked before call are reported
+ *       immediately (same as cap_blocking()). Cancellation is not consumed.
+ *       CIER bits of channel are restored on return (e.g reactor keeps them)
+ */
+int32_t cap_wait(void *p, uint8_t ch, struct cap_result_raw *result,
+                 uint32_t timeout_ms, int cancel_fd);
+
+/**
+ * @brief Same as cap_wait(), result carries timestamp and UIO event count
+ *
+ * @param p Pointer to PWM base address
+ * @param ch PWM channel (0 to 7)
+ * @param ev Capture result, timestamp and event count
+ * @param timeout_ms Maximum wait time in mS
+ * @param cancel_fd Wait is cancelled once it's readable (e.g eventfd), -1 for none
+ * @return int32_t 0 on success (check cap_wait())
+ * @note Event count of UIO device is read even if edges were locked before
+ *       call, so gaps between consecutive results show missed interrupts
+ */
+int32_t cap_wait_event(void *p, uint8_t ch, struct cap_event *ev,
+                       uint32_t timeout_ms, int cancel_fd);
+
 /**
  * @brief Convert capture raw results into nS
  * 
@@ -0,0 +1,87 @@
+#ifndef GROUP_H
+#define GROUP_H
+/**
+ * @file group.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Synchronized multi channel update using PWM group registers
+ * @version 0.1
+ * @date 2024-10-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "rw.h"
+#include "pwm.h"
+
+/**
+ * @brief PWM group (PGR0 ... PGR3) with staged member updates
+ *
+ */
+struct pwm_group {
+    void *base;
+    uint8_t grp;            // group index [0, 3]
+    uint8_t mask;           // member channels (bit per channel)
+    int8_t en;              // staged enable: 1, disable: 0, none: -1
+    struct rw_txn txn;      // staged period updates
+};
+
+/**
+ * @brief Assign channels to group
+ *
+ * @param g Group to be initialized
+ * @param base Base address of PWM peripheral
+ * @param grp Group index [0, 3]
+ * @param mask Member channels (bit per channel)
+ * @return int32_t 0 on success
+ * @note Clock, pre-scaler and active state of members must be configured
+ *       before (e.g set_pwm_config() with en = false)
+ */
+int32_t pwm_group_init(struct pwm_group *g, void *base, uint8_t grp, uint8_t mask);
+
+/**
+ * @brief Stage period and duty cycle of member channel
+ *
+ * @param g Group
+ * @param ch Member channel [0, 7]
+ * @param period Entire and Active cycles
+ * @return int32_t 0 on success
+ */
+int32_t pwm_group_period(struct pwm_group *g, uint8_t ch, struct pwm_period period);
+
+/**
+ * @brief Stage enable / disable of all members
+ *
+ * @param g Group
+ * @param en true: Enable and start members in phase, false: Stop members at
+ *        end of their common cycle and gate their clock
+ * @return int32_t 0 on success
+ */
+int32_t pwm_group_enable(struct pwm_group *g, bool en);
+
+/**
+ * @brief Apply all staged updates
+ *
+ * @param g Group
+ * @return int32_t 0 on success, -ETIMEDOUT if disabling didn't see end of
+ *         cycle (members are disabled anyway)
+ * @note Periods are written back to back (hardware latches them at end of
+ *       current cycle, so in phase members update in same cycle). Enable:
+ *       group holds members, PCGR and PER in single write each, then group
+ *       start bit alone releases them. Disable: waits for end of cycle of
+ *       members (window bound to UIO descriptor only, check pwm_en()), then
+ *       group, PER and PCGR are cleared back to back
+ */
+int32_t pwm_group_commit(struct pwm_group *g);
+
+/**
+ * @brief Remove all channels from group
+ *
+ * @param g Group
+ * @return int32_t 0 on success
+ */
+int32_t pwm_group_release(struct pwm_group *g);
+
+#endif // GROUP_H
@@ -0,0 +1,68 @@
+#ifndef IRQ_H
+#define IRQ_H
+/**
+ * @file irq.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief PWM interrupt delivered through UIO file descriptor
+ * @version 0.1
+ * @date 2024-10-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+
+/**
+ * @brief Bind UIO file descriptor to PWM register window
+ *
+ * @param base Base address of PWM peripheral
+ * @param fd UIO device file descriptor
+ * @return int32_t 0 on success
+ * @note rw_open_uio() binds its own descriptor. Descriptor is switched to
+ *       non blocking mode, so several waiters can share it. Not thread safe
+ */
+int32_t pwm_irq_attach(void *base, int fd);
+
+/**
+ * @brief Unbind UIO file descriptor from PWM register window
+ *
+ * @param base Base address of PWM peripheral
+ * @return int32_t 0 on success
+ */
+int32_t pwm_irq_detach(void *base);
+
+/**
+ * @brief UIO file descriptor of PWM register window
+ *
+ * @param base Base address of PWM peripheral
+ * @return int File descriptor, -1 if there is no interrupt (e.g RAM backend)
+ */
+int pwm_irq_fd(void *base);
+
+/**
+ * @brief Unmask interrupt line and wait for next interrupt
+ *
+ * @param fd UIO device file descriptor
+ * @param cancel_fd Wait is cancelled once it's readable (e.g eventfd), -1 for none
+ * @param timeout_ms Maximum wait time in mS
+ * @param count Total interrupt count reported by UIO (can be NULL). Not
+ *              updated if another waiter consumed the event
+ * @return int32_t 0 on interrupt, -ETIMEDOUT on timeout, -ECANCELED if cancelled
+ * @note Caller still has to check status registers, interrupt line is shared
+ *       by all PWM and capture channels
+ */
+int32_t pwm_irq_wait(int fd, int cancel_fd, uint32_t timeout_ms, uint32_t *count);
+
+/**
+ * @brief Total interrupt count of UIO device bound to register window
+ *
+ * @param base Base address of PWM peripheral
+ * @param count Event count (/sys/class/uio/uioN/event, check uio_get_event_count())
+ * @return int32_t 0 on success, -ENOENT if window has no descriptor, -ENODATA
+ *         if no count is known yet
+ * @note Falls back to last count read by pwm_irq_wait() if descriptor is not
+ *       UIO device node. Doesn't consume events of descriptor
+ */
+int32_t pwm_irq_count(void *base, uint32_t *count);
+
+#endif // IRQ_H
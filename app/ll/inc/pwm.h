@@ -14,6 +14,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "rw.h"
+
 /**
  * @brief Active high/low state of out pulse
  * 
@@ -32,6 +34,17 @@ struct pwm_period {
     uint16_t act;
 };
 
+/**
+ * @brief Precomputed duty cycle update of single channel
+ * @note Built once by pwm_duty_init(). Updates are single PPR write
+ *       without reading it back
+ */
+struct pwm_duty {
+    void *ppr;          // PPR address of channel
+    uint32_t entire;    // entire field, already in position
+    uint32_t scale;     // number of duty levels (entire + 1)
+};
+
 /**
  * @brief Active duration can not be greater than Entire
  * 
@@ -69,14 +82,27 @@ int32_t clk_bypass(void *base, uint8_t ch, bool bypass);
  */
 int32_t is_pwm_en(void *base, uint8_t ch, bool *en);
 
+/**
+ * @brief Wait for end of current PWM cycle
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @return int32_t 0 on success, -ETIMEDOUT if cycle didn't finish in two periods
+ * @note Sleeps on PWM period interrupt (PIER/PISR) through UIO descriptor of
+ *       window (check irq.h), otherwise polls PISR with bounded sleeps
+ */
+int32_t pwm_wait_cycle(void *base, uint8_t ch);
+
 /**
  * @brief Enable PWM channel
  * 
  * @param base Base address of PWM peripheral
  * @param ch Channel index [0, 7]
  * @param en true: Enable PWM, false: Disable PWM
- * @return int32_t 0 on success 
- * @note In case of disabling channel, this method block until current cycle finish
+ * @return int32_t 0 on success, -ETIMEDOUT if current cycle didn't finish
+ *         (channel is disabled anyway)
+ * @note In case of disabling channel bound to UIO descriptor, this method blocks
+ *       until current cycle finish or two periods elapse (check pwm_wait_cycle())
  */
 int32_t pwm_en(void *base, uint8_t ch, bool en);
 
@@ -110,4 +136,54 @@ int32_t get_period(void *base, uint8_t ch, struct pwm_period *period);
  */
 int32_t set_act_state(void *p, uint8_t ch, enum act_state state);
 
-#endif // PWM_H
\ No newline at end of file
+/**
+ * @brief Configure dead zone of channel pair (ch, ch ^ 1)
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @param en true: Complementary output with dead zone, false: Independent
+ * @param intv Dead zone interval in PWMxy clock cycles (after divider)
+ * @return int32_t 0 on success
+ */
+int32_t set_dead_zone(void *base, uint8_t ch, bool en, uint8_t intv);
+
+/**
+ * @brief Prepare duty cycle fast path
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @param duty Fast path to be filled with current entire cycles
+ * @return int32_t 0 on success
+ * @note Call it again after changing period (entire cycles)
+ */
+int32_t pwm_duty_init(void *base, uint8_t ch, struct pwm_duty *duty);
+
+/**
+ * @brief Set duty cycle in 16bit fraction (single register write)
+ *
+ * @param duty Prepared fast path
+ * @param frac Duty cycle in 1/65536 (0 to 65535)
+ * @note Every active cycle count [0, entire] is reachable
+ */
+static inline void pwm_duty_frac(const struct pwm_duty *duty, uint16_t frac)
+{
+    // scale <= 65536, so product fits in 32bit and act <= entire
+    writel(duty->ppr, duty->entire | ((duty->scale * frac) >> 16));
+}
+
+/**
+ * @brief Set duty cycle in permille (single register write)
+ *
+ * @param duty Prepared fast path
+ * @param permille Duty cycle in 1/1000 (0 to 1000)
+ */
+static inline void pwm_duty_permille(const struct pwm_duty *duty, uint16_t permille)
+{
+    uint32_t act = (duty->scale * (uint32_t)permille) / 1000;
+    if(act >= duty->scale)
+        act = duty->scale - 1;
+
+    writel(duty->ppr, duty->entire | act);
+}
+
+#endif // PWM_H
@@ -32,7 +32,11 @@
 #define CRLR_OFFSET         0x0114 // Capture Rise Lock Register
 #define CFLR_OFFSET         0x0118 // Capture Fall Lock Register
 
-#define PWM_REG_OFFSET(base, ch) ((base) + 0x20 * (ch))
+#define PWM_REG_BLOCK_SIZE       0x20
+#define PWM_REG_OFFSET(base, ch) ((base) + PWM_REG_BLOCK_SIZE * (ch))
+
+// Size of PWM register window (PIER ... CFLR of channel 7)
+#define PWM_WINDOW_SIZE         0x0400
 
 // PWM Clock Configuration Register details
 #define PWM_CLK_SRC_SEL         0x07
@@ -45,6 +49,13 @@
 #define PWMx_CLK_BYPASS(x)      ((x) + 16)
 #define PWMx_CLK_GATING(x)      (x)
 
+// PWM Dead Zone Control Register details
+#define PDZCRxy_OFFSET(ch)      (PDZCR01_OFFSET + 0x04 * ((ch) / 2) )
+#define PWM_DZ_EN               0x00
+#define PWM_DZ_INTV             0x08
+#define PWM_DZ_INTV_MASK        0xFF
+#define PDZCRxy_VALUE(en, intv) ( (((intv) & PWM_DZ_INTV_MASK) << PWM_DZ_INTV) | ((en) << PWM_DZ_EN) )
+
 // PWM Enable Register details
 #define PWMx_EN(x)              (x)
 
@@ -54,7 +65,7 @@
 #define SET_PWM_PRESCALE(x, pre)    \
 do {                                \
     (x) &= ~PWM_PRESCAL_K_MASK;     \
-    (x) |= pre;                     \
+    (x) |= (pre) & PWM_PRESCAL_K_MASK; \
 } while(0)
 #define GET_PWM_PRESCALER(x)    ( (x) & PWM_PRESCAL_K_MASK )
 
@@ -62,12 +73,16 @@ do {                                \
 #define PWM_ENTIRE_CYCLE        0x10
 #define SET_PWM_PERIOD(x, ent, act) \
 do {                                \
-    (x) = (act);                    \
-    (x) |= ((ent) << PWM_ENTIRE_CYCLE); \
+    (x) = (act) & 0xFFFF;           \
+    (x) |= (((ent) & 0xFFFF) << PWM_ENTIRE_CYCLE); \
 } while(0)
 #define GET_PWM_ACT(x)          ( (x) & 0x0000FFFF)
 #define GET_PWM_ENTIRE(x)       (((x) & 0xFFFF0000) >> PWM_ENTIRE_CYCLE)
 
+// PWM IRQ Enable / Status Register (end of PWM cycle)
+#define PCIEx(x)                (x)
+#define PISx(x)                 (x)
+
 // PWM Capture IRQ Enable Register 
 #define CFIEx(x)                ( 2 * (x) + 1 )
 #define CRIEx(x)                ( 2 * (x) )
@@ -76,6 +91,13 @@ do {                                \
 #define CFISx(x)                ( 2 * (x) + 1 )
 #define CRISx(x)                ( 2 * (x) )
 
+// PWM Group Register
+#define PWM_GROUP               0x04
+#define PGRx_OFFSET(g)          (PGR0_OFFSET + 0x04 * (g))
+#define PWMG_CS_MASK            0xFFFF
+#define PWMG_EN                 0x10
+#define PWMG_START              0x11
+
 // Capture Enable Register
 #define CAPx_EN(x)              (x)
 
@@ -0,0 +1,342 @@
+#ifndef REGISTERS_HPP
+#define REGISTERS_HPP
+/**
+ * @file registers.hpp
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief T113-Sx PWM registers as constexpr descriptors (C++17)
+ * @version 0.1
+ * @date 2024-10-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * @note Every field knows its register, offset, width and access type.
+ *       Multi field writes are composed into one constant at compile time:
+ * @code
+ *  using namespace t113::pwm;
+ *  // single read-modify-write of PCR2 with constant mask and value
+ *  modify(p, pcr<2>::prescal_k::make<19>(), pcr<2>::act_sta::make<1>());
+ *  // whole register write, no read
+ *  write(p, ppr<2>::entire_cycle::make(99), ppr<2>::act_cycle::make(70));
+ * @endcode
+ */
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+extern "C" {
+#include "registers.h"
+#include "bitops.h"
+#include "rw.h"
+}
+
+namespace t113::pwm {
+
+/**
+ * @brief Access type of register field
+ *
+ */
+enum class access {
+    rw,     // read / write
+    ro,     // read only (hardware status)
+    w1c     // read / write 1 to clear
+};
+
+/**
+ * @brief Register descriptor
+ *
+ * @tparam Offset Offset from base address of PWM peripheral
+ * @tparam W1c Write 1 to clear bits of register, never written back by modify()
+ */
+template <uint32_t Offset, uint32_t W1c = 0>
+struct reg {
+    static_assert(Offset < PWM_WINDOW_SIZE && !(Offset & 0x03), "invalid register offset");
+    static constexpr uint32_t offset = Offset;
+    static constexpr uint32_t w1c = W1c;
+};
+
+template <typename Field>
+struct field_value;
+
+/**
+ * @brief Register field descriptor
+ *
+ * @tparam Reg Register which holds this field
+ * @tparam Shift Index of first bit
+ * @tparam Width Number of bits
+ * @tparam Access Access type
+ */
+template <typename Reg, unsigned Shift, unsigned Width, access Access = access::rw>
+struct field {
+    static_assert(Width > 0 && Shift + Width <= 32, "field does not fit in register");
+
+    using reg_t = Reg;
+    static constexpr unsigned shift = Shift;
+    static constexpr unsigned width = Width;
+    static constexpr access type = Access;
+    static constexpr uint32_t max = (Width == 32) ? 0xFFFFFFFFu : ((1u << Width) - 1);
+    static constexpr uint32_t mask = max << Shift;
+
+    /**
+     * @brief Field value checked at compile time
+     */
+    template <uint32_t V>
+    static constexpr field_value<field> make()
+    {
+        static_assert(V <= max, "value does not fit in field");
+        static_assert(Access != access::ro, "field is read only");
+        return field_value<field>{V << Shift};
+    }
+
+    /**
+     * @brief Field value masked at run time
+     */
+    static constexpr field_value<field> make(uint32_t v)
+    {
+        static_assert(Access != access::ro, "field is read only");
+        return field_value<field>{(v << Shift) & mask};
+    }
+
+    static constexpr uint32_t get(uint32_t reg)
+    {
+        return (reg & mask) >> Shift;
+    }
+};
+
+/**
+ * @brief Value of single field, already shifted into position
+ *
+ */
+template <typename Field>
+struct field_value {
+    using field_t = Field;
+    uint32_t bits;
+};
+
+namespace detail {
+
+template <typename First, typename... Rest>
+struct same_reg {
+    static constexpr bool value =
+        ((First::field_t::reg_t::offset == Rest::field_t::reg_t::offset) && ...);
+};
+
+template <typename... Values>
+constexpr bool disjoint()
+{
+    uint32_t seen = 0;
+    bool ok = true;
+    ((ok = ok && !(seen & Values::field_t::mask), seen |= Values::field_t::mask), ...);
+    return ok;
+}
+
+} // namespace detail
+
+/**
+ * @brief Compose multiple fields of one register
+ *
+ */
+template <typename... Values>
+struct composed {
+    static_assert(sizeof...(Values) > 0, "no field");
+    static_assert(detail::same_reg<Values...>::value, "fields belong to different registers");
+    static_assert(detail::disjoint<Values...>(), "fields overlap");
+
+    using reg_t = typename std::tuple_element_t<0, std::tuple<Values...>>::field_t::reg_t;
+    static constexpr uint32_t mask = (Values::field_t::mask | ...);
+};
+
+template <typename... Values>
+constexpr uint32_t compose(Values... v)
+{
+    (void)composed<Values...>::mask;
+    return (v.bits | ...);
+}
+
+/**
+ * @brief Write whole register, not mentioned fields are written as 0
+ *
+ */
+template <typename... Values>
+inline void write(void *base, Values... v)
+{
+    using reg_t = typename composed<Values...>::reg_t;
+    writel(static_cast<uint8_t *>(base) + reg_t::offset, compose(v...));
+}
+
+/**
+ * @brief Read-modify-write of mentioned fields
+ * @note Pending write 1 to clear bits are read back as 1, they are dropped
+ *       so only mentioned w1c fields are cleared
+ */
+template <typename... Values>
+constexpr uint32_t modify_value(uint32_t cur, Values... v)
+{
+    using reg_t = typename composed<Values...>::reg_t;
+    return (cur & ~(composed<Values...>::mask | reg_t::w1c)) | compose(v...);
+}
+
+template <typename... Values>
+inline void modify(void *base, Values... v)
+{
+    using reg_t = typename composed<Values...>::reg_t;
+    void *addr = static_cast<uint8_t *>(base) + reg_t::offset;
+    writel(addr, modify_value(readl_relaxed(addr), v...));
+}
+
+/**
+ * @brief Read single field
+ *
+ */
+template <typename Field>
+inline uint32_t read(void *base)
+{
+    return Field::get(readl(static_cast<uint8_t *>(base) + Field::reg_t::offset));
+}
+
+/**
+ * @brief Global registers
+ *
+ */
+template <unsigned Ch>
+struct pier : reg<PIER_OFFSET> {
+    static_assert(Ch < 8, "invalid channel");
+    using pcie = field<pier, Ch, 1>;
+};
+
+template <unsigned Ch>
+struct pisr : reg<PISR_OFFSET, 0xFF> {
+    static_assert(Ch < 8, "invalid channel");
+    using pis = field<pisr, Ch, 1, access::w1c>;
+};
+
+template <unsigned Ch>
+struct cier : reg<CIER_OFFSET> {
+    static_assert(Ch < 8, "invalid channel");
+    using crie = field<cier, CRIEx(Ch), 1>;
+    using cfie = field<cier, CFIEx(Ch), 1>;
+};
+
+template <unsigned Ch>
+struct cisr : reg<CISR_OFFSET, 0xFFFF> {
+    static_assert(Ch < 8, "invalid channel");
+    using cris = field<cisr, CRISx(Ch), 1, access::w1c>;
+    using cfis = field<cisr, CFISx(Ch), 1, access::w1c>;
+};
+
+// Shared between (ch) and (ch ^ 1)
+template <unsigned Ch>
+struct pccr : reg<PCCRxy_OFFSET(Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using clk_div_m = field<pccr, 0, 4>;
+    using clk_src_sel = field<pccr, PWM_CLK_SRC_SEL, 2>;
+};
+
+template <unsigned Ch>
+struct pcgr : reg<PCGR_OFFSET> {
+    static_assert(Ch < 8, "invalid channel");
+    using clk_gating = field<pcgr, PWMx_CLK_GATING(Ch), 1>;
+    using clk_bypass = field<pcgr, PWMx_CLK_BYPASS(Ch), 1>;
+};
+
+// Shared between (ch) and (ch ^ 1)
+template <unsigned Ch>
+struct pdzcr : reg<PDZCRxy_OFFSET(Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using dz_en = field<pdzcr, PWM_DZ_EN, 1>;
+    using dz_intv = field<pdzcr, PWM_DZ_INTV, 8>;
+};
+
+template <unsigned Ch>
+struct per : reg<PER_OFFSET> {
+    static_assert(Ch < 8, "invalid channel");
+    using en = field<per, PWMx_EN(Ch), 1>;
+};
+
+template <unsigned G>
+struct pgr : reg<PGRx_OFFSET(G)> {
+    static_assert(G < PWM_GROUP, "invalid group");
+    using cs = field<pgr, 0, 16>;
+    using en = field<pgr, PWMG_EN, 1>;
+    using start = field<pgr, PWMG_START, 1>;
+};
+
+template <unsigned Ch>
+struct cer : reg<CER_OFFSET> {
+    static_assert(Ch < 8, "invalid channel");
+    using en = field<cer, CAPx_EN(Ch), 1>;
+};
+
+/**
+ * @brief Per channel registers
+ *
+ */
+template <unsigned Ch>
+struct pcr : reg<PWM_REG_OFFSET(PCR_OFFSET, Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using prescal_k = field<pcr, 0, 8>;
+    using act_sta = field<pcr, PWM_ACT_STA, 1>;
+};
+
+template <unsigned Ch>
+struct ppr : reg<PWM_REG_OFFSET(PPR_OFFSET, Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using act_cycle = field<ppr, 0, 16>;
+    using entire_cycle = field<ppr, PWM_ENTIRE_CYCLE, 16>;
+};
+
+template <unsigned Ch>
+struct pcntr : reg<PWM_REG_OFFSET(PCNTR_OFFSET, Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using cnt = field<pcntr, 0, 16, access::ro>;
+};
+
+template <unsigned Ch>
+struct ppcntr : reg<PWM_REG_OFFSET(PPCNTR_OFFSET, Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using cnt = field<ppcntr, 0, 16, access::ro>;
+};
+
+template <unsigned Ch>
+struct ccr : reg<PWM_REG_OFFSET(CCR_OFFSET, Ch), BIT(CRLF) | BIT(CFLF)> {
+    static_assert(Ch < 8, "invalid channel");
+    using capinv = field<ccr, CAPINV, 1>;
+    using cfte = field<ccr, CFTE, 1>;
+    using crte = field<ccr, CRTE, 1>;
+    using cflf = field<ccr, CFLF, 1, access::w1c>;
+    using crlf = field<ccr, CRLF, 1, access::w1c>;
+};
+
+template <unsigned Ch>
+struct crlr : reg<PWM_REG_OFFSET(CRLR_OFFSET, Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using lock = field<crlr, 0, 16, access::ro>;
+};
+
+template <unsigned Ch>
+struct cflr : reg<PWM_REG_OFFSET(CFLR_OFFSET, Ch)> {
+    static_assert(Ch < 8, "invalid channel");
+    using lock = field<cflr, 0, 16, access::ro>;
+};
+
+// Descriptors must agree with C macros of registers.h
+static_assert(pcr<0>::prescal_k::mask == PWM_PRESCAL_K_MASK);
+static_assert(pccr<0>::clk_div_m::mask == PWMxy_CLK_DIV_M_MASK);
+static_assert(compose(pccr<2>::clk_src_sel::make<1>(), pccr<2>::clk_div_m::make<5>()) ==
+              PCCRxy_VALUE(1, 5));
+static_assert(pccr<4>::offset == pccr<5>::offset);
+static_assert(compose(pcgr<2>::clk_gating::make<1>(), pcgr<3>::clk_gating::make<1>()) == 0x0C);
+static_assert(compose(pdzcr<3>::dz_en::make<1>(), pdzcr<3>::dz_intv::make<0x20>()) ==
+              PDZCRxy_VALUE(1, 0x20));
+static_assert(pdzcr<2>::offset == PDZCR23_OFFSET);
+static_assert(ppr<7>::offset == PWM_REG_OFFSET(PPR_OFFSET, 7));
+static_assert(compose(ppr<0>::entire_cycle::make<0x1234>(), ppr<0>::act_cycle::make<0x56>()) ==
+              0x12340056);
+
+// w1c fields are covered by w1c mask of their register
+static_assert(pisr<7>::pis::mask == (pisr<7>::w1c & pisr<7>::pis::mask));
+static_assert((cisr<7>::cris::mask | cisr<7>::cfis::mask) & cisr<7>::w1c);
+static_assert((ccr<0>::crlf::mask | ccr<0>::cflf::mask) == ccr<0>::w1c);
+
+} // namespace t113::pwm
+
+#endif // REGISTERS_HPP
@@ -2,22 +2,236 @@
 #define RW_H
 /**
  * @brief Read / Write helper functions
- * 
+ *
  */
 #include <stdint.h>
 #include <stdbool.h>
 
+/**
+ * @brief Memory barriers
+ * @note Device memory accesses are ordered against each other by hardware.
+ *       Barriers order them against normal memory accesses (and compiler)
+ */
+#if defined(__aarch64__)
+#define rw_mb()     __asm__ __volatile__("dmb sy" ::: "memory")
+#define rw_rmb()    __asm__ __volatile__("dmb ld" ::: "memory")
+#define rw_wmb()    __asm__ __volatile__("dmb st" ::: "memory")
+#elif defined(__arm__)
+#define rw_mb()     __asm__ __volatile__("dmb sy" ::: "memory")
+#define rw_rmb()    __asm__ __volatile__("dmb sy" ::: "memory")
+#define rw_wmb()    __asm__ __volatile__("dmb st" ::: "memory")
+#else
+#define rw_mb()     __sync_synchronize()
+#define rw_rmb()    __asm__ __volatile__("" ::: "memory")
+#define rw_wmb()    __asm__ __volatile__("" ::: "memory")
+#endif
+
+/**
+ * @brief Write register, ordered after all previous memory accesses
+ *
+ * @param base Register address
+ * @param value Register value
+ */
 void writel(void* base, uint32_t value);
 
+/**
+ * @brief Read register, ordered before all following memory accesses
+ *
+ * @param base Register address
+ * @return uint32_t Register value
+ */
 uint32_t readl(void* base);
 
+/**
+ * @brief Write register without barrier
+ * @note Use it for back to back register accesses
+ */
+void writel_relaxed(void* base, uint32_t value);
+
+/**
+ * @brief Read register without barrier
+ * @note Use it for back to back register accesses
+ */
+uint32_t readl_relaxed(void* base);
+
+/**
+ * @brief Read block of consecutive registers in one pass
+ *
+ * @param base Address of first register
+ * @param buf Buffer to be filled
+ * @param count Number of 32bit registers
+ * @note Unlike Linux readsl(), address is incremented for each register
+ */
+void readsl(void *base, uint32_t *buf, uint32_t count);
+
+/**
+ * @brief Write block of consecutive registers in one pass
+ *
+ * @param base Address of first register
+ * @param buf Register values
+ * @param count Number of 32bit registers
+ */
+void writesl(void *base, const uint32_t *buf, uint32_t count);
+
 /**
  * @brief Read, Modify and Write single bit in 32bit
- * 
- * @param base Base address 
+ *
+ * @param base Base address
  * @param index Index of bit [0, 31]
  * @param bit Desired value of target bit
  */
-void rmwb(void *base, uint8_t index, bool bit);   
+void rmwb(void *base, uint8_t index, bool bit);
+
+/**
+ * @brief Shadow register cache statistics
+ *
+ */
+struct rw_shadow_stats {
+    uint64_t reads;         // readl() calls inside shadowed window
+    uint64_t mmio_reads;    // reads which went to hardware
+    uint64_t saved_reads;   // reads served from shadow copy
+    uint64_t writes;        // writel() calls inside shadowed window
+};
+
+/**
+ * @brief Attach write-through shadow copy to PWM register window
+ *
+ * @param base Base address of PWM peripheral
+ * @return int32_t 0 on success
+ * @note After attaching, readl() of configuration registers is served from
+ *       shadow copy. Status registers (PISR, CISR, PGRx, PCNTR, PPCNTR, CCR,
+ *       CRLR and CFLR) are always read from hardware. Without any attached
+ *       shadow, accessors skip the lookup (single load and branch).
+ *       Shadow copy is not thread safe: attach / detach / sync it only while
+ *       no other thread accesses registers, and don't attach it while a
+ *       capture reactor runs on another thread (check cap_reactor.h)
+ */
+int32_t rw_shadow_attach(void *base);
+
+/**
+ * @brief Detach shadow copy from PWM register window
+ *
+ * @param base Base address of PWM peripheral
+ * @return int32_t 0 on success
+ */
+int32_t rw_shadow_detach(void *base);
+
+/**
+ * @brief Reload shadow copy from hardware
+ *
+ * @param base Base address of PWM peripheral
+ * @return int32_t 0 on success
+ * @note Call it in case registers are modified outside of this library
+ */
+int32_t rw_shadow_sync(void *base);
+
+/**
+ * @brief Report shadow copy statistics
+ *
+ * @param base Base address of PWM peripheral
+ * @param stats Statistics to be filled
+ * @return int32_t 0 on success
+ */
+int32_t rw_shadow_stats(void *base, struct rw_shadow_stats *stats);
+
+/**
+ * @brief Track clock configuration writes of PWM register window
+ *
+ * @param base Base address of PWM peripheral
+ * @return int32_t 0 on success
+ * @note Called by rw_open_*() (check backend.h). Window table is not thread
+ *       safe, attach / detach only while no other thread accesses registers
+ */
+int32_t rw_window_attach(void *base);
+
+/**
+ * @brief Stop tracking PWM register window
+ *
+ * @param base Base address of PWM peripheral
+ * @return int32_t 0 on success
+ */
+int32_t rw_window_detach(void *base);
+
+/**
+ * @brief Clock configuration epoch of channel in register window
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @param epoch Epoch, incremented by every write to PCCRxy or PCR of channel
+ *        inside this window
+ * @return int32_t 0 on success, -ENOENT if window is not tracked
+ */
+int32_t rw_clk_epoch(void *base, uint8_t ch, uint32_t *epoch);
+
+#define RW_TXN_MAX          16
+
+/**
+ * @brief Pending update of single register in transaction
+ *
+ */
+struct rw_txn_reg {
+    uint32_t off;           // register offset from base address
+    uint32_t set;           // bits to be set
+    uint32_t clr;           // bits to be cleared
+};
+
+/**
+ * @brief Register transaction
+ * @note Bit updates are merged per register and applied by rw_txn_commit()
+ *       with at most one read and one write per register
+ */
+struct rw_txn {
+    void *base;
+    uint8_t nr;
+    int32_t err;
+    struct rw_txn_reg regs[RW_TXN_MAX];
+};
+
+/**
+ * @brief Start new transaction
+ *
+ * @param txn Transaction to be initialized
+ * @param base Base address of PWM peripheral
+ */
+void rw_txn_begin(struct rw_txn *txn, void *base);
+
+/**
+ * @brief Stage update of register field
+ *
+ * @param txn Transaction
+ * @param off Register offset from base address
+ * @param mask Bits to be updated
+ * @param value New value of masked bits
+ */
+void rw_txn_field(struct rw_txn *txn, uint32_t off, uint32_t mask, uint32_t value);
+
+/**
+ * @brief Stage update of single bit
+ *
+ * @param txn Transaction
+ * @param off Register offset from base address
+ * @param index Index of bit [0, 31]
+ * @param bit Desired value of target bit
+ */
+void rw_txn_bit(struct rw_txn *txn, uint32_t off, uint8_t index, bool bit);
+
+/**
+ * @brief Stage write of whole register (no read is needed)
+ *
+ * @param txn Transaction
+ * @param off Register offset from base address
+ * @param value Register value
+ */
+void rw_txn_write(struct rw_txn *txn, uint32_t off, uint32_t value);
+
+/**
+ * @brief Apply all staged updates
+ *
+ * @param txn Transaction
+ * @return int32_t 0 on success
+ * @note Registers are written in order of their first update in transaction.
+ *       Nothing is written if staging failed (e.g too many registers)
+ */
+int32_t rw_txn_commit(struct rw_txn *txn);
 
-#endif // RW_H
\ No newline at end of file
+#endif // RW_H
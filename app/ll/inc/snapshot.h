@@ -0,0 +1,69 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+/**
+ * @file snapshot.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Whole PWM block state in single pass
+ * @version 0.1
+ * @date 2024-10-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "soc.h"
+#include "config.h"
+
+/**
+ * @brief Decoded state of single channel
+ *
+ */
+struct pwm_ch_state {
+    struct pwm_config pwm;      // PWM configuration (including act_state)
+    bool gated;                 // clock passed (PCGR gating bit)
+    bool bypass;                // clock bypassed to output
+    bool pis;                   // PWM period IRQ status
+    bool cap_en;                // capture enabled
+    bool rising;                // capture rising edge enabled (CRTE)
+    bool falling;               // capture falling edge enabled (CFTE)
+    bool crlf;                  // capture rise lock flag
+    bool cflf;                  // capture fall lock flag
+    bool cris;                  // capture rising IRQ status
+    bool cfis;                  // capture falling IRQ status
+    uint16_t cnt;               // PWM counter (PCNTR)
+    uint16_t pulse_cnt;         // PWM pulse counter (PPCNTR)
+    uint16_t rlock;             // capture rise lock value (CRLR)
+    uint16_t flock;             // capture fall lock value (CFLR)
+};
+
+/**
+ * @brief Raw global registers and decoded state of all channels
+ *
+ */
+struct pwm_snapshot {
+    uint32_t pier;
+    uint32_t pisr;
+    uint32_t cier;
+    uint32_t cisr;
+    uint32_t pccr[PWM_CHANNEL / 2];
+    uint32_t pcgr;
+    uint32_t per;
+    uint32_t cer;
+    struct pwm_ch_state ch[PWM_CHANNEL];
+};
+
+/**
+ * @brief Read all PWM registers once and decode state of every channel
+ *
+ * @param p Pointer to PWM base address
+ * @param snap Snapshot to be filled
+ * @return int32_t 0 on success
+ * @note Registers are read in one pass (global registers and channel
+ *       blocks in ascending order). Use it instead of get_pwm_config() for
+ *       monitoring several channels
+ */
+int32_t pwm_snapshot(void *p, struct pwm_snapshot *snap);
+
+#endif // SNAPSHOT_H
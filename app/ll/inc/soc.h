@@ -12,6 +12,8 @@
  */
 #include <stdint.h>
 
+#define PWM_BASE_ADDR   0x02000C00UL    // Physical address of PWM peripheral
+
 #define HOSC_FREQ       24000000UL      // Main clock frequency (Hz)
 #define APB0_FREQ       100000000UL     // APB0 bus clock frequency (Hz)
 
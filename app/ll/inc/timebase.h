@@ -0,0 +1,102 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+/**
+ * @file timebase.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Division free cycles <-> nS conversion (fixed point reciprocal)
+ * @version 0.1
+ * @date 2024-10-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdint.h>
+#include "clk.h"
+
+/**
+ * @brief Counter clock of channel (src / (div * (pre + 1)))
+ * @note Built once from clock configuration, conversions are then
+ *       32x32->64 bit multiply and shift (no 64bit division)
+ */
+struct pwm_timebase {
+    uint32_t ns_mul;        // nS per cycle in Q(ns_shift)
+    uint8_t ns_shift;
+    uint32_t cyc_mul;       // cycles per nS in Q(cyc_shift)
+    uint8_t cyc_shift;
+    uint32_t tick_hz;       // counter clock frequency (rounded, informative)
+    uint32_t src_hz;        // source clock frequency
+    uint32_t div;           // total division, div * (pre + 1)
+};
+
+/**
+ * @brief Build timebase from clock configuration
+ *
+ * @param tb Timebase to be filled
+ * @param clk Clock source and divider
+ * @param pre Pre-scaler
+ * @return int32_t 0 on success
+ */
+int32_t timebase_init(struct pwm_timebase *tb, struct pwm_clk clk, uint8_t pre);
+
+/**
+ * @brief Report cached timebase of channel
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @param tb Timebase to be filled
+ * @return int32_t 0 on success
+ * @note Cache is invalidated by any write to PCCRxy or PCR of channel in same
+ *       window, then it's rebuilt from hardware (two register reads). Windows
+ *       not opened by rw_open_*() are read every time. Not thread safe
+ */
+int32_t timebase_get(void *base, uint8_t ch, struct pwm_timebase *tb);
+
+/**
+ * @brief Fill timebase cache of channel after configuring it
+ *
+ * @param base Base address of PWM peripheral
+ * @param ch Channel index [0, 7]
+ * @param clk Clock source and divider written into PCCRxy
+ * @param pre Pre-scaler written into PCR
+ * @return int32_t 0 on success
+ */
+int32_t timebase_update(void *base, uint8_t ch, struct pwm_clk clk, uint8_t pre);
+
+/**
+ * @brief Convert number of counter cycles into nS (rounded)
+ *
+ * @note Relative error is below 2^-31, so it's sub nS for 16bit counters
+ */
+static inline uint64_t tb_cycles_to_ns(const struct pwm_timebase *tb, uint32_t cycles)
+{
+    uint64_t round = (1ULL << tb->ns_shift) >> 1;
+    return ((uint64_t)cycles * tb->ns_mul + round) >> tb->ns_shift;
+}
+
+/**
+ * @brief Convert nS into number of counter cycles (rounded)
+ *
+ */
+static inline uint64_t tb_ns_to_cycles(const struct pwm_timebase *tb, uint32_t ns)
+{
+    uint64_t round = (1ULL << tb->cyc_shift) >> 1;
+    return ((uint64_t)ns * tb->cyc_mul + round) >> tb->cyc_shift;
+}
+
+/**
+ * @brief Frequency of signal with period of given counter cycles (rounded)
+ *
+ * @note Exact source clock over total division, not rounded tick_hz. Single
+ *       32bit division (hardware UDIV on Cortex-A7): result is 0 once
+ *       divisor exceeds twice source clock, so it always fits in 32bit
+ */
+static inline uint32_t tb_cycles_to_hz(const struct pwm_timebase *tb, uint32_t cycles)
+{
+    uint64_t den = (uint64_t)tb->div * cycles;
+    if(!den || den > 2ULL * tb->src_hz)
+        return 0;
+
+    return (tb->src_hz + (uint32_t)den / 2) / (uint32_t)den;
+}
+
+#endif // TIMEBASE_H
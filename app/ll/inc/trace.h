@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+/**
+ * @file trace.h
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Register access accounting (per register and per API)
+ * @version 0.1
+ * @date 2024-10-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * @note Enabled by RW_TRACE definition (cmake -DLL_RW_TRACE=ON).
+ *       Otherwise all macros compile to nothing.
+ *       Counters are not thread safe.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef RW_TRACE
+
+/**
+ * @brief Calling API scope (filled by RW_TRACE_API)
+ *
+ */
+struct rw_trace_scope {
+    struct rw_trace_api *api;   // NULL for nested calls
+    uint64_t start_ns;
+};
+
+struct rw_trace_scope rw_trace_enter(const char *name);
+
+void rw_trace_leave(struct rw_trace_scope *scope);
+
+/**
+ * @brief Account single bus access
+ *
+ * @param addr Register address
+ * @param write true: write access, false: read access
+ */
+void rw_trace_access(void *addr, bool write);
+
+/**
+ * @brief Print per register and per API table
+ *
+ * @param f Output stream
+ */
+void rw_trace_dump(FILE *f);
+
+/**
+ * @brief Reset all counters
+ *
+ */
+void rw_trace_reset(void);
+
+/**
+ * @brief Account accesses and time of current function.
+ *        Only outermost traced function is accounted
+ */
+#define RW_TRACE_API()                                              \
+    struct rw_trace_scope __rw_scope                                \
+        __attribute__((cleanup(rw_trace_leave), unused)) =          \
+        rw_trace_enter(__func__)
+
+#define RW_TRACE_ACCESS(addr, write)    rw_trace_access((addr), (write))
+
+#else
+
+#define RW_TRACE_API()                  do { } while(0)
+#define RW_TRACE_ACCESS(addr, write)    do { } while(0)
+#define rw_trace_dump(f)                do { (void)(f); } while(0)
+#define rw_trace_reset()                do { } while(0)
+
+#endif // RW_TRACE
+
+#endif // TRACE_H
@@ -0,0 +1,161 @@
+/**
+ * @file backend.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief PWM register window backends (UIO, /dev/mem, RAM, file)
+ * @version 0.1
+ * @date 2024-10-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "soc.h"
+#include "registers.h"
+#include "backend.h"
+#include "irq.h"
+#include "rw.h"
+
+/**
+ * @brief Reset backend, so rw_close() is safe after any failed rw_open_*()
+ *
+ */
+static void init_backend(struct rw_backend *be, enum rw_backend_type type)
+{
+    memset(be, 0, sizeof(*be));
+    be->type = type;
+    be->fd = -1;
+}
+
+/**
+ * @brief Map register window which starts at offset (in file) off
+ *
+ */
+static int32_t map_window(struct rw_backend *be, int flags, uint64_t off)
+{
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    uint64_t start = off & ~(page - 1);
+
+    be->map_size = (off - start) + PWM_WINDOW_SIZE;
+    be->map_size = (be->map_size + page - 1) & ~(page - 1);
+    be->map = mmap(NULL, be->map_size, PROT_READ | PROT_WRITE, flags, be->fd, start);
+    if(be->map == MAP_FAILED) {
+        int32_t ret = -errno;
+        if(be->fd >= 0)
+            close(be->fd);
+        be->fd = -1;
+        be->map = NULL;
+        return ret;
+    }
+
+    be->base = be->map + (off - start);
+
+    // clock epochs of this window (check rw_clk_epoch())
+    int32_t ret = rw_window_attach(be->base);
+    if(ret) {
+        munmap(be->map, be->map_size);
+        if(be->fd >= 0)
+            close(be->fd);
+        be->fd = -1;
+        be->map = NULL;
+        be->base = NULL;
+        return ret;
+    }
+
+    return 0;
+}
+
+int32_t rw_open_uio(struct rw_backend *be, const char *dev)
+{
+    if(!be || !dev)
+        return -EFAULT;
+
+    init_backend(be, RW_BACKEND_UIO);
+    be->fd = open(dev, O_RDWR);
+    if(be->fd < 0)
+        return -errno;
+
+    // map0 starts at page of PWM_BASE_ADDR, registers are at page offset
+    int32_t ret = map_window(be, MAP_SHARED, PWM_BASE_ADDR & (sysconf(_SC_PAGESIZE) - 1));
+    if(ret)
+        return ret;
+
+    // PWM interrupt is delivered through same descriptor
+    ret = pwm_irq_attach(be->base, be->fd);
+    if(ret)
+        rw_close(be);
+
+    return ret;
+}
+
+int32_t rw_open_devmem(struct rw_backend *be, uint64_t phys)
+{
+    if(!be)
+        return -EFAULT;
+
+    init_backend(be, RW_BACKEND_DEVMEM);
+    be->fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if(be->fd < 0)
+        return -errno;
+
+    return map_window(be, MAP_SHARED, phys);
+}
+
+int32_t rw_open_ram(struct rw_backend *be)
+{
+    if(!be)
+        return -EFAULT;
+
+    init_backend(be, RW_BACKEND_RAM);
+
+    return map_window(be, MAP_PRIVATE | MAP_ANONYMOUS, 0);
+}
+
+int32_t rw_open_file(struct rw_backend *be, const char *path)
+{
+    if(!be || !path)
+        return -EFAULT;
+
+    init_backend(be, RW_BACKEND_FILE);
+    be->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if(be->fd < 0)
+        return -errno;
+
+    struct stat st;
+    if(fstat(be->fd, &st) || (st.st_size < PWM_WINDOW_SIZE && ftruncate(be->fd, PWM_WINDOW_SIZE))) {
+        int32_t ret = -errno;
+        close(be->fd);
+        be->fd = -1;
+        return ret;
+    }
+
+    return map_window(be, MAP_SHARED, 0);
+}
+
+void rw_close(struct rw_backend *be)
+{
+    if(!be)
+        return;
+
+    if(be->type == RW_BACKEND_UIO && be->base)
+        pwm_irq_detach(be->base);
+
+    if(be->base)
+        rw_window_detach(be->base);
+
+    if(be->map)
+        munmap(be->map, be->map_size);
+
+    if(be->fd >= 0)
+        close(be->fd);
+
+    be->map = NULL;
+    be->base = NULL;
+    be->fd = -1;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file cap_convert.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Batch conversion of raw capture results (NEON / SSE2 / scalar)
+ * @version 0.1
+ * @date 2024-10-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "cap_convert.h"
+
+_Static_assert(sizeof(struct cap_result_raw) == 4, "raw result must be packed on/off pair");
+
+/**
+ * @brief Frequency and duty of one result, integer division (UDIV on Cortex-A7)
+ *
+ */
+static inline void finish(const struct pwm_timebase *tb, uint32_t on, uint32_t off,
+                          struct cap_sample *out)
+{
+    uint32_t period = on + off;
+
+    out->freq_hz = tb_cycles_to_hz(tb, period);
+    out->duty = period ? (on * 1000 + period / 2) / period : 0;
+}
+
+void cap_convert_scalar(const struct pwm_timebase *tb, const struct cap_result_raw *raw,
+                        struct cap_sample *out, uint32_t n)
+{
+    for(uint32_t i = 0; i < n; i++) {
+        out[i].on_ns = tb_cycles_to_ns(tb, raw[i].on_cycles);
+        out[i].off_ns = tb_cycles_to_ns(tb, raw[i].off_cycles);
+        finish(tb, raw[i].on_cycles, raw[i].off_cycles, &out[i]);
+    }
+}
+
+#if defined(__ARM_NEON)
+
+const char *cap_convert_isa(void)
+{
+    return "neon";
+}
+
+void cap_convert(const struct pwm_timebase *tb, const struct cap_result_raw *raw,
+                 struct cap_sample *out, uint32_t n)
+{
+    // same Q multiply and rounding as tb_cycles_to_ns(), shift is uniform
+    uint32x2_t mul = vdup_n_u32(tb->ns_mul);
+    uint64x2_t round = vdupq_n_u64((1ULL << tb->ns_shift) >> 1);
+    int64x2_t shift = vdupq_n_s64(-(int64_t)tb->ns_shift);
+
+    uint32_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        // de-interleave 4 on/off pairs
+        uint16x4x2_t v = vld2_u16((const uint16_t *)&raw[i]);
+        uint32x4_t on = vmovl_u16(v.val[0]);
+        uint32x4_t off = vmovl_u16(v.val[1]);
+
+        uint64x2_t on_lo = vshlq_u64(vaddq_u64(vmull_u32(vget_low_u32(on), mul), round), shift);
+        uint64x2_t on_hi = vshlq_u64(vaddq_u64(vmull_u32(vget_high_u32(on), mul), round), shift);
+        uint64x2_t off_lo = vshlq_u64(vaddq_u64(vmull_u32(vget_low_u32(off), mul), round), shift);
+        uint64x2_t off_hi = vshlq_u64(vaddq_u64(vmull_u32(vget_high_u32(off), mul), round), shift);
+
+        out[i + 0].on_ns = vgetq_lane_u64(on_lo, 0);
+        out[i + 1].on_ns = vgetq_lane_u64(on_lo, 1);
+        out[i + 2].on_ns = vgetq_lane_u64(on_hi, 0);
+        out[i + 3].on_ns = vgetq_lane_u64(on_hi, 1);
+        out[i + 0].off_ns = vgetq_lane_u64(off_lo, 0);
+        out[i + 1].off_ns = vgetq_lane_u64(off_lo, 1);
+        out[i + 2].off_ns = vgetq_lane_u64(off_hi, 0);
+        out[i + 3].off_ns = vgetq_lane_u64(off_hi, 1);
+
+        for(uint8_t j = 0; j < 4; j++)
+            finish(tb, raw[i + j].on_cycles, raw[i + j].off_cycles, &out[i + j]);
+    }
+
+    cap_convert_scalar(tb, raw + i, out + i, n - i);
+}
+
+#elif defined(__SSE2__)
+
+const char *cap_convert_isa(void)
+{
+    return "sse2";
+}
+
+void cap_convert(const struct pwm_timebase *tb, const struct cap_result_raw *raw,
+                 struct cap_sample *out, uint32_t n)
+{
+    // same Q multiply and rounding as tb_cycles_to_ns(), shift is uniform
+    __m128i mul = _mm_set1_epi32(tb->ns_mul);
+    __m128i round = _mm_set1_epi64x((1ULL << tb->ns_shift) >> 1);
+    __m128i shift = _mm_cvtsi32_si128(tb->ns_shift);
+    __m128i low16 = _mm_set1_epi32(0xFFFF);
+
+    uint32_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        // 4 on/off pairs, on is low half of each 32bit lane
+        __m128i v = _mm_loadu_si128((const __m128i *)&raw[i]);
+        __m128i on = _mm_and_si128(v, low16);
+        __m128i off = _mm_srli_epi32(v, 16);
+
+        // _mm_mul_epu32() multiplies lanes 0 and 2
+        __m128i on_02 = _mm_srl_epi64(_mm_add_epi64(_mm_mul_epu32(on, mul), round), shift);
+        __m128i on_13 = _mm_srl_epi64(_mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(on, 32), mul), round), shift);
+        __m128i off_02 = _mm_srl_epi64(_mm_add_epi64(_mm_mul_epu32(off, mul), round), shift);
+        __m128i off_13 = _mm_srl_epi64(_mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(off, 32), mul), round), shift);
+
+        uint64_t on_ns[4], off_ns[4];
+        _mm_storeu_si128((__m128i *)&on_ns[0], _mm_unpacklo_epi64(on_02, on_13));
+        _mm_storeu_si128((__m128i *)&on_ns[2], _mm_unpackhi_epi64(on_02, on_13));
+        _mm_storeu_si128((__m128i *)&off_ns[0], _mm_unpacklo_epi64(off_02, off_13));
+        _mm_storeu_si128((__m128i *)&off_ns[2], _mm_unpackhi_epi64(off_02, off_13));
+
+        for(uint8_t j = 0; j < 4; j++) {
+            out[i + j].on_ns = on_ns[j];
+            out[i + j].off_ns = off_ns[j];
+            finish(tb, raw[i + j].on_cycles, raw[i + j].off_cycles, &out[i + j]);
+        }
+    }
+
+    cap_convert_scalar(tb, raw + i, out + i, n - i);
+}
+
+#else
+
+const char *cap_convert_isa(void)
+{
+    return "scalar";
+}
+
+void cap_convert(const struct pwm_timebase *tb, const struct cap_result_raw *raw,
+                 struct cap_sample *out, uint32_t n)
+{
+    cap_convert_scalar(tb, raw, out, n);
+}
+
+#endif
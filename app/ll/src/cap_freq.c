@@ -0,0 +1,119 @@
+/**
+ * @file cap_freq.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Frequency counter on capture results (reciprocal / gated)
+ * @version 0.1
+ * @date 2024-10-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+
+#include "cap_freq.h"
+
+#define CAP_FREQ_SATURATED      0xFFFF
+#define MHZ_NS                  1000000000000ULL    // mHz * nS
+
+int32_t cap_freq_init(struct cap_freq *f, const struct pwm_timebase *tb,
+                      enum cap_freq_mode mode, uint32_t gate_ms, uint32_t irq_gap)
+{
+    if(!f || !tb)
+        return -EFAULT;
+
+    if(mode > CAP_FREQ_AUTO || !gate_ms || !tb->src_hz || !tb->div)
+        return -EINVAL;
+
+    // gated counts delivered results, meaningless unless delivery is checked
+    if(mode == CAP_FREQ_GATED && !irq_gap)
+        return -EINVAL;
+
+    f->tb = *tb;
+    f->mode = mode;
+    f->gate_ns = (uint64_t)gate_ms * 1000000ULL;
+    f->cycles = 0;
+    f->periods = 0;
+    f->saturated = 0;
+    f->irq_gap = irq_gap;
+    f->irq_count = 0;
+    f->lost = false;
+    f->dropped = 0;
+
+    return 0;
+}
+
+/**
+ * @brief a * b / c without 64bit overflow of a * b (b is small)
+ *
+ */
+static uint64_t mul_div(uint64_t a, uint32_t b, uint64_t c)
+{
+    return (a / c) * b + ((a % c) * b) / c;
+}
+
+static void reciprocal(const struct cap_freq *f, struct cap_freq_result *res)
+{
+    // periods * src / (div * cycles), exact source clock instead of rounded
+    // tick_hz. periods * src_hz fits in 64bit, one counter cycle over whole gate
+    uint64_t ticks = (uint64_t)f->periods * f->tb.src_hz;
+
+    res->freq_mhz = mul_div(ticks, 1000, f->cycles * f->tb.div);
+    res->resolution_mhz = res->freq_mhz / f->cycles;
+    if(!res->resolution_mhz)
+        res->resolution_mhz = 1;
+}
+
+static void gated(const struct cap_freq *f, uint64_t elapsed, struct cap_freq_result *res)
+{
+    // periods between first and last result (fence post)
+    res->freq_mhz = mul_div(MHZ_NS, f->periods - 1, elapsed);
+    res->resolution_mhz = MHZ_NS / elapsed;
+}
+
+int32_t cap_freq_push(struct cap_freq *f, const struct cap_event *ev,
+                      struct cap_freq_result *res)
+{
+    if(!f->periods)
+        f->start_ns = ev->ts_ns;
+    else if(ev->irq_count - f->irq_count > f->irq_gap)
+        f->lost = true;
+    // event count 0 is unknown, results may have been missed
+    if(!ev->irq_count)
+        f->lost = true;
+    f->irq_count = ev->irq_count;
+
+    uint32_t on = ev->raw.on_cycles;
+    uint32_t off = ev->raw.off_cycles;
+    f->cycles += on + off;
+    f->saturated += (on >= CAP_FREQ_SATURATED || off >= CAP_FREQ_SATURATED);
+    f->periods++;
+
+    uint64_t elapsed = ev->ts_ns - f->start_ns;
+    if(elapsed < f->gate_ns || f->periods < 2)
+        return 0;
+
+    enum cap_freq_mode mode = f->mode;
+    if(mode == CAP_FREQ_AUTO || !f->cycles)
+        mode = (f->saturated || !f->cycles) ? CAP_FREQ_GATED : CAP_FREQ_RECIPROCAL;
+
+    // gated window is only valid if every period was delivered
+    bool drop = (mode == CAP_FREQ_GATED) && (!f->irq_gap || f->lost);
+    if(drop)
+        f->dropped++;
+
+    if(res && !drop) {
+        res->gate_ns = elapsed;
+        res->periods = f->periods;
+        res->mode = mode;
+        if(mode == CAP_FREQ_GATED)
+            gated(f, elapsed, res);
+        else
+            reciprocal(f, res);
+    }
+    f->cycles = 0;
+    f->periods = 0;
+    f->saturated = 0;
+    f->lost = false;
+
+    return !drop;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file cap_log.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Memory mapped binary log of capture results
+ * @version 0.1
+ * @date 2024-10-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "soc.h"
+#include "cap_log.h"
+
+/**
+ * @brief Fill array offsets of log with given capacity and file size
+ * @note Fails if any offset overflows or file can't be mapped as a whole
+ */
+static int32_t layout(struct cap_log_header *hdr, uint64_t capacity, uint64_t *size)
+{
+    uint64_t raw_size, ts_size, irq_size, end;
+
+    hdr->header_size = sizeof(*hdr);
+    hdr->capacity = capacity;
+    hdr->raw_off = sizeof(*hdr);
+
+    if(__builtin_mul_overflow(capacity, sizeof(struct cap_result_raw), &raw_size) ||
+       __builtin_mul_overflow(capacity, sizeof(uint64_t), &ts_size) ||
+       __builtin_mul_overflow(capacity, sizeof(uint32_t), &irq_size) ||
+       __builtin_add_overflow(hdr->raw_off + 7, raw_size, &end))
+        return -EINVAL;
+    hdr->ts_off = end & ~7ULL;
+
+    if(__builtin_add_overflow(hdr->ts_off, ts_size, &hdr->irq_off) ||
+       __builtin_add_overflow(hdr->irq_off, irq_size, &end) || end > SIZE_MAX)
+        return -EINVAL;
+
+    *size = end;
+
+    return 0;
+}
+
+static void bind_arrays(struct cap_log *log)
+{
+    log->hdr = log->map;
+    log->raw = log->map + log->hdr->raw_off;
+    log->ts_ns = log->map + log->hdr->ts_off;
+    log->irq_count = log->map + log->hdr->irq_off;
+}
+
+static int32_t fail(struct cap_log *log, int32_t ret)
+{
+    if(log->map)
+        munmap(log->map, log->map_size);
+    if(log->fd >= 0)
+        close(log->fd);
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+
+    return ret;
+}
+
+int32_t cap_log_create(struct cap_log *log, const char *path, uint64_t capacity,
+                       uint8_t ch, struct pwm_clk clk, uint8_t pre)
+{
+    if(!log || !path)
+        return -EFAULT;
+
+    if(!capacity || check_ch(ch) || check_clk(clk))
+        return -EINVAL;
+
+    struct pwm_timebase tb;
+    int32_t ret = timebase_init(&tb, clk, pre);
+    if(ret)
+        return ret;
+
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    log->writer = true;
+
+    struct cap_log_header hdr = {
+        .magic = CAP_LOG_MAGIC,
+        .version = CAP_LOG_VERSION,
+        .ch = ch,
+        .src = clk.src,
+        .div = clk.div,
+        .pre = pre,
+        .tick_hz = tb.tick_hz,
+    };
+    uint64_t size;
+    if(layout(&hdr, capacity, &size))
+        return fail(log, -EINVAL);
+    log->map_size = size;
+
+    log->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(log->fd < 0)
+        return fail(log, -errno);
+
+    // allocate blocks now, appending must never wait for file system
+    ret = posix_fallocate(log->fd, 0, log->map_size);
+    if(ret)
+        return fail(log, -ret);
+
+    log->map = mmap(NULL, log->map_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, log->fd, 0);
+    if(log->map == MAP_FAILED) {
+        log->map = NULL;
+        return fail(log, -errno);
+    }
+
+    memcpy(log->map, &hdr, sizeof(hdr));
+    bind_arrays(log);
+
+    return 0;
+}
+
+int32_t cap_log_flush(struct cap_log *log)
+{
+    if(!log || !log->map)
+        return -EFAULT;
+
+    if(msync(log->map, log->map_size, MS_ASYNC))
+        return -errno;
+
+    return 0;
+}
+
+int32_t cap_log_open(struct cap_log *log, const char *path)
+{
+    if(!log || !path)
+        return -EFAULT;
+
+    memset(log, 0, sizeof(*log));
+    log->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(log->fd < 0)
+        return fail(log, -errno);
+
+    struct stat st;
+    if(fstat(log->fd, &st))
+        return fail(log, -errno);
+
+    if((uint64_t)st.st_size < sizeof(struct cap_log_header) ||
+       (uint64_t)st.st_size > SIZE_MAX)
+        return fail(log, -EINVAL);
+
+    log->map_size = st.st_size;
+    log->map = mmap(NULL, log->map_size, PROT_READ, MAP_SHARED, log->fd, 0);
+    if(log->map == MAP_FAILED) {
+        log->map = NULL;
+        return fail(log, -errno);
+    }
+
+    // layout must match what this version would write for same capacity
+    const struct cap_log_header *hdr = log->map;
+    struct cap_log_header expect;
+    uint64_t size;
+    if(hdr->magic != CAP_LOG_MAGIC || hdr->version != CAP_LOG_VERSION ||
+       layout(&expect, hdr->capacity, &size) || size > log->map_size ||
+       hdr->header_size != expect.header_size || hdr->raw_off != expect.raw_off ||
+       hdr->ts_off != expect.ts_off || hdr->irq_off != expect.irq_off ||
+       hdr->count > hdr->capacity)
+        return fail(log, -EINVAL);
+
+    bind_arrays(log);
+    log->count = hdr->count;
+
+    return 0;
+}
+
+int32_t cap_log_timebase(const struct cap_log *log, struct pwm_timebase *tb)
+{
+    if(!log || !log->hdr)
+        return -EFAULT;
+
+    struct pwm_clk clk = {.src = log->hdr->src, .div = log->hdr->div};
+
+    return timebase_init(tb, clk, log->hdr->pre);
+}
+
+int32_t cap_log_close(struct cap_log *log)
+{
+    if(!log)
+        return -EFAULT;
+
+    int32_t ret = 0;
+    if(log->writer && log->map && msync(log->map, log->map_size, MS_SYNC))
+        ret = -errno;
+
+    fail(log, 0);
+
+    return ret;
+}
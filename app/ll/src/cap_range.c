@@ -0,0 +1,166 @@
+/**
+ * @file cap_range.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Auto-ranging capture (retune divider / pre-scaler to input signal)
+ * @version 0.1
+ * @date 2024-10-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+
+#include "soc.h"
+#include "trace.h"
+#include "rw.h"
+#include "registers.h"
+#include "bitops.h"
+#include "timebase.h"
+#include "cap_range.h"
+
+#define CAP_RANGE_MAX_TOTAL     (BIT(DIV_256) * (PWM_PRESCAL_K_MASK + 1))
+
+/**
+ * @brief Split total division on given divider (pre-scaler rounded up)
+ *
+ */
+static bool split_total(uint32_t total, uint8_t div, uint8_t *pre)
+{
+    uint32_t k = (total + BIT(div) - 1) >> div;
+    if(k > PWM_PRESCAL_K_MASK + 1)
+        return false;
+
+    *pre = k ? k - 1 : 0;
+    return true;
+}
+
+int32_t cap_range_init(struct cap_range *r, void *p, uint8_t ch,
+                       const struct cap_config *config)
+{
+    RW_TRACE_API();
+    if(!r || !config)
+        return -EFAULT;
+
+    int32_t ret = set_cap_config(p, ch, config);
+    if(ret)
+        return ret;
+
+    // partner channel may have moved divider, take what was written
+    uint32_t pccr = readl_relaxed(p + PCCRxy_OFFSET(ch));
+    uint32_t pcr = readl_relaxed(p + PWM_REG_OFFSET(PCR_OFFSET, ch));
+
+    r->base = p;
+    r->ch = ch;
+    r->src = config->clk.src;
+    r->total = BIT(GET_CLK_DIV(pccr)) * (GET_PWM_PRESCALER(pcr) + 1);
+    r->retunes = 0;
+    r->probe = 0;
+
+    return 0;
+}
+
+/**
+ * @brief Move channel to new total division (src stays the same)
+ *
+ */
+static int32_t retune(struct cap_range *r, uint32_t total)
+{
+    void *p = r->base;
+    uint8_t ch = r->ch;
+    struct clk_plan plan;
+    struct pwm_clk clk = {.src = r->src};
+    uint8_t pre;
+    int32_t ret = -EBUSY;
+
+    // smallest divider keeps finest pre-scaler steps
+    uint8_t div = DIV_1;
+    while(div < DIV_256 && !split_total(total, div, &pre))
+        div++;
+    clk.div = div;
+    if(split_total(total, div, &pre))
+        ret = clk_arbitrate(p, ch, clk, pre, &plan);
+
+    // running partner pins divider, round total on it instead
+    if(ret == -EBUSY) {
+        clk.div = GET_CLK_DIV(readl_relaxed(p + PCCRxy_OFFSET(ch)));
+        if(clk.div > DIV_256 || !split_total(total, clk.div, &pre))
+            return -EBUSY;
+        ret = clk_arbitrate(p, ch, clk, pre, &plan);
+    }
+    if(ret)
+        return ret;
+
+    /**
+     * @brief Edges locked on old clock are meaningless after retune.
+     *        CRLF/CFLF and CISR are write-1-to-clear
+     */
+    struct rw_txn txn;
+    rw_txn_begin(&txn, p);
+    clk_plan_stage(&txn, ch, &plan);
+    rw_txn_field(&txn, PWM_REG_OFFSET(CCR_OFFSET, ch), BIT(CRLF) | BIT(CFLF),
+                 BIT(CRLF) | BIT(CFLF));
+    rw_txn_write(&txn, CISR_OFFSET, BIT(CRISx(ch)) | BIT(CFISx(ch)));
+    ret = rw_txn_commit(&txn);
+    if(ret)
+        return ret;
+
+    r->total = BIT(plan.clk.div) * (plan.pre + 1);
+    r->retunes++;
+
+    return timebase_update(p, ch, plan.clk, plan.pre);
+}
+
+int32_t cap_range_update(struct cap_range *r, const struct cap_result_raw *raw)
+{
+    RW_TRACE_API();
+    if(!r || !raw)
+        return -EFAULT;
+
+    uint32_t count = (raw->on_cycles > raw->off_cycles) ? raw->on_cycles : raw->off_cycles;
+    uint32_t probe = r->probe;
+    if(!count && !probe)
+        return 0;
+
+    r->probe = 0;
+    if(count >= CAP_RANGE_LOW && count < CAP_RANGE_HIGH)
+        return 0;
+
+    /**
+     * @brief Small count may be wrapped slow pulse. Trust it only if it
+     *        followed previous probe (count scaled down with clock), else
+     *        slow down clock and expect count / CAP_RANGE_PROBE next
+     */
+    if(count < CAP_RANGE_LOW && r->total < CAP_RANGE_MAX_TOTAL &&
+       (!probe || count > 2 * probe)) {
+        uint64_t total = (uint64_t)r->total * CAP_RANGE_PROBE;
+        if(total > CAP_RANGE_MAX_TOTAL)
+            total = CAP_RANGE_MAX_TOTAL;
+
+        uint32_t old = r->total;
+        int32_t ret = retune(r, total);
+        if(ret)
+            return ret;
+        r->probe = ((uint64_t)count * old + r->total - 1) / r->total + 1;
+
+        return 1;
+    }
+
+    // less than one counter cycle
+    if(!count)
+        count = 1;
+
+    // saturated counts hide real width, at least bring them to target
+    uint64_t total = ((uint64_t)r->total * count + CAP_RANGE_TARGET - 1) / CAP_RANGE_TARGET;
+    if(total < 1)
+        total = 1;
+    if(total > CAP_RANGE_MAX_TOTAL)
+        total = CAP_RANGE_MAX_TOTAL;
+
+    // already at the end of range
+    if(total == r->total)
+        return 0;
+
+    int32_t ret = retune(r, total);
+
+    return ret ? ret : 1;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file cap_reactor.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Single thread capture of all channels on shared PWM interrupt
+ * @version 0.1
+ * @date 2024-10-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "trace.h"
+#include "rw.h"
+#include "registers.h"
+#include "bitops.h"
+#include "irq.h"
+#include "capture.h"
+#include "cap_reactor.h"
+
+#define CAP_EDGES(ch)       ( BIT(CRISx(ch)) | BIT(CFISx(ch)) )
+#define CAP_REACTOR_SYNC    64      // wakeups between reads of UIO event count
+
+int32_t cap_reactor_init(struct cap_reactor *r, void *base)
+{
+    if(!r || !base)
+        return -EFAULT;
+
+    memset(r, 0, sizeof(*r));
+    r->base = base;
+    r->unmask = true;
+    r->uio_fd = pwm_irq_fd(base);
+    if(r->uio_fd < 0)
+        return -ENODEV;
+
+    r->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(r->stop_fd < 0)
+        return -errno;
+
+    r->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(r->epoll_fd < 0) {
+        int32_t ret = -errno;
+        close(r->stop_fd);
+        return ret;
+    }
+
+    // edge triggered: one wakeup per interrupt burst
+    struct epoll_event uio = {.events = EPOLLIN | EPOLLET, .data.fd = r->uio_fd};
+    struct epoll_event stop = {.events = EPOLLIN, .data.fd = r->stop_fd};
+    if(epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->uio_fd, &uio) ||
+       epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->stop_fd, &stop)) {
+        int32_t ret = -errno;
+        close(r->epoll_fd);
+        close(r->stop_fd);
+        return ret;
+    }
+
+    return 0;
+}
+
+int32_t cap_reactor_add(struct cap_reactor *r, uint8_t ch, cap_reactor_cb cb, void *arg)
+{
+    RW_TRACE_API();
+    if(!r || !cb)
+        return -EFAULT;
+
+    if(check_ch(ch))
+        return -EINVAL;
+
+    struct cap_reactor_ch *c = &r->ch[ch];
+    c->cb = cb;
+    c->arg = arg;
+    c->locked = 0;
+    c->overrun = 0;
+    SET_BIT(r->mask, ch);
+
+    return en_cap_irq(r->base, ch, true, true);
+}
+
+int32_t cap_reactor_remove(struct cap_reactor *r, uint8_t ch)
+{
+    RW_TRACE_API();
+    if(!r)
+        return -EFAULT;
+
+    if(check_ch(ch))
+        return -EINVAL;
+
+    CLEAR_BIT(r->mask, ch);
+    r->ch[ch].cb = NULL;
+
+    return en_cap_irq(r->base, ch, false, false);
+}
+
+/**
+ * @brief Account UIO event count of wakeup
+ * @note Without irqcontrol level triggered line fires until flags are
+ *       cleared, so jumps of count don't mean lost interrupts
+ */
+static void account(struct cap_reactor *r, uint32_t count)
+{
+    uint32_t gap = count - r->irq_count;
+    if(r->counted && r->unmask && gap > 1)
+        r->irq_overrun += gap - 1;
+
+    r->irq_count = count;
+    r->counted = true;
+}
+
+/**
+ * @brief Collect locked edges of all served channels
+ *
+ */
+static void dispatch(struct cap_reactor *r)
+{
+    RW_TRACE_API();
+    uint32_t cisr = readl(r->base + CISR_OFFSET);
+    uint32_t handled = 0;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    struct cap_event ev = {
+        .irq_count = r->irq_count,
+        .ts_ns = (uint64_t)ts.tv_sec * NSEC_IN_SEC + ts.tv_nsec,
+    };
+
+    for(uint8_t ch = 0; ch < PWM_CHANNEL; ch++) {
+        uint32_t edges = cisr & CAP_EDGES(ch);
+        if(!IS_SET(r->mask, ch) || !edges)
+            continue;
+
+        struct cap_reactor_ch *c = &r->ch[ch];
+        void *lock = r->base + PWM_REG_OFFSET(CRLR_OFFSET, ch);
+        // CRLR and CFLR are adjacent
+        if(IS_SET(edges, CRISx(ch)))
+            c->raw.off_cycles = CRLR(readl_relaxed(lock));
+        if(IS_SET(edges, CFISx(ch)))
+            c->raw.on_cycles = CFLR(readl_relaxed(lock + 4));
+        uint8_t fresh = edges >> CRISx(ch);
+        if(c->locked & fresh)
+            c->overrun++;
+        c->locked |= fresh;
+        handled |= edges;
+    }
+
+    if(!handled)
+        return;
+
+    /**
+     * @brief Same state as clear_cap_irq(): IRQ status and lock flags are
+     *        write-1-to-clear, flags of other channels are untouched
+     */
+    struct rw_txn txn;
+    rw_txn_begin(&txn, r->base);
+    rw_txn_write(&txn, CISR_OFFSET, handled);
+    for(uint8_t ch = 0; ch < PWM_CHANNEL; ch++) {
+        uint32_t edges = handled & CAP_EDGES(ch);
+        if(!edges)
+            continue;
+        uint32_t ccr = (IS_SET(edges, CRISx(ch)) ? BIT(CRLF) : 0) |
+                       (IS_SET(edges, CFISx(ch)) ? BIT(CFLF) : 0);
+        rw_txn_field(&txn, PWM_REG_OFFSET(CCR_OFFSET, ch), BIT(CRLF) | BIT(CFLF), ccr);
+    }
+    rw_txn_commit(&txn);
+
+    // callbacks run after clear, so next edges are not lost while they run
+    for(uint8_t ch = 0; ch < PWM_CHANNEL; ch++) {
+        struct cap_reactor_ch *c = &r->ch[ch];
+        if(c->locked != 0x03 || !c->cb)
+            continue;
+        c->locked = 0;
+        ev.raw = c->raw;
+        ev.ch = ch;
+        c->cb(&ev, c->arg);
+    }
+}
+
+/**
+ * @brief Read UIO event count of wakeup
+ * @return int32_t 0 on success or if no event is pending
+ */
+static int32_t read_count(struct cap_reactor *r)
+{
+    uint32_t count;
+    ssize_t len = read(r->uio_fd, &count, sizeof(count));
+    if(len == sizeof(count))
+        account(r, count);
+    else if(len < 0 && errno != EAGAIN)
+        return -errno;
+
+    return 0;
+}
+
+int32_t cap_reactor_run(struct cap_reactor *r)
+{
+    if(!r)
+        return -EFAULT;
+
+    /**
+     * @brief Baseline of event count (none if window has no count). read()
+     *        also consumes event pending since descriptor was opened, so
+     *        only new interrupts wake epoll
+     */
+    r->counted = !pwm_irq_count(r->base, &r->irq_count);
+    r->wakeups = 0;
+    int32_t ret = read_count(r);
+    if(ret)
+        return ret;
+    // edges locked before first interrupt
+    dispatch(r);
+
+    for(;;) {
+        // re-enable interrupt line, drivers without irqcontrol never mask it
+        if(r->unmask) {
+            uint32_t one = 1;
+            if(write(r->uio_fd, &one, sizeof(one)) < 0) {
+                if(errno != ENOSYS)
+                    return -errno;
+                r->unmask = false;
+            }
+        }
+
+        // edge triggered: reported once per interrupt, even if count isn't read
+        struct epoll_event ev[2];
+        int n = epoll_wait(r->epoll_fd, ev, 2, -1);
+        if(n < 0) {
+            if(errno == EINTR)
+                continue;
+            return -errno;
+        }
+
+        for(int i = 0; i < n; i++) {
+            if(ev[i].data.fd == r->stop_fd) {
+                uint64_t cnt;
+                if(read(r->stop_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN)
+                    return -errno;
+                return 0;
+            }
+        }
+
+        /**
+         * @brief Masked line raises one interrupt per re-arm, so wakeup is
+         *        counted and event count is read back only every
+         *        CAP_REACTOR_SYNC wakeups (events taken by other waiters)
+         */
+        if(!r->unmask || ++r->wakeups % CAP_REACTOR_SYNC == 0) {
+            ret = read_count(r);
+            if(ret)
+                return ret;
+        } else if(r->counted) {
+            r->irq_count++;
+        }
+        dispatch(r);
+    }
+}
+
+int32_t cap_reactor_stop(struct cap_reactor *r)
+{
+    if(!r)
+        return -EFAULT;
+
+    uint64_t one = 1;
+    if(write(r->stop_fd, &one, sizeof(one)) < 0)
+        return -errno;
+
+    return 0;
+}
+
+void cap_reactor_release(struct cap_reactor *r)
+{
+    if(!r)
+        return;
+
+    for(uint8_t ch = 0; ch < PWM_CHANNEL; ch++)
+        if(IS_SET(r->mask, ch))
+            cap_reactor_remove(r, ch);
+
+    close(r->epoll_fd);
+    close(r->stop_fd);
+    r->epoll_fd = -1;
+    r->stop_fd = -1;
+}
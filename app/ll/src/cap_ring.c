@@ -0,0 +1,49 @@
+/**
+ * @file cap_ring.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Lock-free single producer / single consumer ring of capture results
+ * @version 0.1
+ * @date 2024-10-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <string.h>
+
+#include "cap_ring.h"
+
+void cap_ring_init(struct cap_ring *r)
+{
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->overflow, 0);
+    r->tail_cache = 0;
+    r->head_cache = 0;
+}
+
+uint32_t cap_ring_pop(struct cap_ring *r, struct cap_result_raw *out, uint32_t max)
+{
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    uint32_t avail = r->head_cache - tail;
+    if(avail < max) {
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        avail = r->head_cache - tail;
+    }
+
+    uint32_t n = (avail < max) ? avail : max;
+    if(!n)
+        return 0;
+
+    // at most two copies, ring wraps once
+    uint32_t slot = tail & (CAP_RING_SIZE - 1);
+    uint32_t first = CAP_RING_SIZE - slot;
+    if(first > n)
+        first = n;
+    memcpy(out, &r->buf[slot], first * sizeof(*out));
+    memcpy(out + first, &r->buf[0], (n - first) * sizeof(*out));
+
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+
+    return n;
+}
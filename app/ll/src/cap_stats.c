@@ -0,0 +1,125 @@
+/**
+ * @file cap_stats.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Streaming statistics of captured pulses (constant memory per channel)
+ * @version 0.1
+ * @date 2024-10-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "cap_stats.h"
+
+int32_t cap_stats_init(struct cap_stats *s, double alpha)
+{
+    if(!s)
+        return -EFAULT;
+
+    if(!(alpha > 0.0 && alpha <= 1.0))
+        return -EINVAL;
+
+    memset(s, 0, sizeof(*s));
+    s->alpha = alpha;
+
+    return 0;
+}
+
+uint8_t cap_stats_bin(uint32_t cycles)
+{
+    if(cycles < (1U << CAP_STATS_SUB_BITS))
+        return cycles;
+
+    uint8_t msb = 31 - __builtin_clz(cycles);
+    uint32_t sub = (cycles >> (msb - CAP_STATS_SUB_BITS)) & ((1U << CAP_STATS_SUB_BITS) - 1);
+    uint32_t bin = ((msb - CAP_STATS_SUB_BITS + 1) << CAP_STATS_SUB_BITS) + sub;
+
+    return (bin < CAP_STATS_BINS) ? bin : CAP_STATS_BINS - 1;
+}
+
+uint32_t cap_stats_bin_low(uint8_t bin)
+{
+    if(bin < (1U << CAP_STATS_SUB_BITS))
+        return bin;
+
+    uint8_t msb = (bin >> CAP_STATS_SUB_BITS) + CAP_STATS_SUB_BITS - 1;
+    uint32_t sub = bin & ((1U << CAP_STATS_SUB_BITS) - 1);
+
+    return (1U << msb) | (sub << (msb - CAP_STATS_SUB_BITS));
+}
+
+static inline void acc_push(struct cap_stats_acc *a, uint64_t n, double alpha, uint32_t x)
+{
+    if(n == 1) {
+        a->mean = x;
+        a->m2 = 0;
+        a->ewma = x;
+        a->min = x;
+        a->max = x;
+        return;
+    }
+
+    double delta = x - a->mean;
+    a->mean += delta / n;
+    a->m2 += delta * (x - a->mean);
+    a->ewma += alpha * (x - a->ewma);
+    if(x < a->min)
+        a->min = x;
+    if(x > a->max)
+        a->max = x;
+}
+
+void cap_stats_push(struct cap_stats *s, const struct cap_result_raw *raw)
+{
+    uint64_t n = ++s->count;
+
+    acc_push(&s->on, n, s->alpha, raw->on_cycles);
+    acc_push(&s->off, n, s->alpha, raw->off_cycles);
+    acc_push(&s->period, n, s->alpha, (uint32_t)raw->on_cycles + raw->off_cycles);
+    s->hist_on[cap_stats_bin(raw->on_cycles)]++;
+    s->hist_off[cap_stats_bin(raw->off_cycles)]++;
+}
+
+void cap_stats_push_batch(struct cap_stats *s, const struct cap_result_raw *raw, uint32_t n)
+{
+    for(uint32_t i = 0; i < n; i++)
+        cap_stats_push(s, &raw[i]);
+}
+
+static void acc_value(const struct cap_stats_acc *a, uint64_t n, double ns,
+                      struct cap_stats_value *v)
+{
+    v->mean_ns = a->mean * ns;
+    v->ewma_ns = a->ewma * ns;
+    v->min_ns = a->min * ns;
+    v->max_ns = a->max * ns;
+    v->stddev_ns = (n > 1) ? sqrt(a->m2 / (n - 1)) * ns : 0;
+}
+
+int32_t cap_stats_snapshot(const struct cap_stats *s, const struct pwm_timebase *tb,
+                           struct cap_stats_snapshot *snap)
+{
+    if(!s || !tb || !snap)
+        return -EFAULT;
+
+    // nS per counter cycle, same Q value as tb_cycles_to_ns()
+    double ns = (double)tb->ns_mul / (double)(1ULL << tb->ns_shift);
+
+    memset(snap, 0, sizeof(*snap));
+    snap->count = s->count;
+    if(!s->count)
+        return 0;
+
+    acc_value(&s->on, s->count, ns, &snap->on);
+    acc_value(&s->off, s->count, ns, &snap->off);
+    acc_value(&s->period, s->count, ns, &snap->period);
+    if(snap->period.mean_ns > 0) {
+        snap->freq_hz = 1e9 / snap->period.mean_ns;
+        snap->duty = 100.0 * s->on.mean / s->period.mean;
+    }
+
+    return 0;
+}
@@ -10,6 +10,7 @@
  */
 
 #include "soc.h"
+#include "trace.h"
 #include "clk.h"
 #include "registers.h"
 #include "bitops.h"
@@ -18,47 +19,62 @@
 
  int32_t en_cap_irq(void *p, uint8_t ch, bool rising, bool falling)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
-    rmwb(p + CIER_OFFSET, CRIEx(ch), rising);
-    rmwb(p + CIER_OFFSET, CFIEx(ch), falling);
+    struct rw_txn txn;
+    rw_txn_begin(&txn, p);
+    rw_txn_bit(&txn, CIER_OFFSET, CRIEx(ch), rising);
+    rw_txn_bit(&txn, CIER_OFFSET, CFIEx(ch), falling);
 
-    return 0;
+    return rw_txn_commit(&txn);
 }
 
  int32_t cap_en(void *p, uint8_t ch, bool rising, bool falling)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
-    rmwb(p + CER_OFFSET, CAPx_EN(ch), rising | falling);
-    rmwb(p + PWM_REG_OFFSET(CCR_OFFSET, ch), CRTE, rising);
-    rmwb(p + PWM_REG_OFFSET(CCR_OFFSET, ch), CFTE, falling);
+    struct rw_txn txn;
+    rw_txn_begin(&txn, p);
+    rw_txn_bit(&txn, CER_OFFSET, CAPx_EN(ch), rising | falling);
+    // CRLF and CFLF are write-1-to-clear, keep them untouched
+    rw_txn_field(&txn, PWM_REG_OFFSET(CCR_OFFSET, ch),
+                 BIT(CRTE) | BIT(CFTE) | BIT(CRLF) | BIT(CFLF),
+                 (rising ? BIT(CRTE) : 0) | (falling ? BIT(CFTE) : 0));
 
-    return 0;
+    return rw_txn_commit(&txn);
 }
 
  int32_t clear_cap_irq(void *p, uint8_t ch, bool rising, bool falling)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
-    if(rising) {
-        rmwb(p + CISR_OFFSET, CRISx(ch), false);
-        rmwb(p + PWM_REG_OFFSET(CCR_OFFSET, ch), CRLF, false);
-    }
+    if(!rising && !falling)
+        return 0;
 
-    if(falling) {
-        rmwb(p + CISR_OFFSET, CFISx(ch), false);
-        rmwb(p + PWM_REG_OFFSET(CCR_OFFSET, ch), CFLF, false);
-    }
+    /**
+     * @brief IRQ status and lock flags are write-1-to-clear. Writing back
+     *        read value would clear flags of other channels/edges too
+     */
+    uint32_t cisr = (rising ? BIT(CRISx(ch)) : 0) | (falling ? BIT(CFISx(ch)) : 0);
+    uint32_t ccr = (rising ? BIT(CRLF) : 0) | (falling ? BIT(CFLF) : 0);
 
-    return 0;
+    struct rw_txn txn;
+    rw_txn_begin(&txn, p);
+    rw_txn_write(&txn, CISR_OFFSET, cisr);
+    rw_txn_field(&txn, PWM_REG_OFFSET(CCR_OFFSET, ch), BIT(CRLF) | BIT(CFLF), ccr);
+
+    return rw_txn_commit(&txn);
 }
 
  int32_t cap_irq(void *p, uint8_t ch, bool *rising, bool *falling)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
     
@@ -75,6 +91,7 @@
 
  int32_t cap_rising_lock(void *p, uint8_t ch, uint16_t *rlock)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -89,6 +106,7 @@
 
  int32_t cap_falling_lock(void *p, uint8_t ch, uint16_t *flock)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -103,6 +121,7 @@
 
  int32_t cap_crlf(void *p, uint8_t ch, bool *crlf)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -117,6 +136,7 @@
 
  int32_t cap_cflf(void *p, uint8_t ch, bool *cflf)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -9,10 +9,12 @@
  * 
  */
 #include "soc.h"
+#include "trace.h"
 #include "rw.h"
 #include "registers.h"
 #include "bitops.h"
 #include "clk.h"
+#include "timebase.h"
 
 /**
  * @brief Map register value into enum
@@ -34,6 +36,7 @@ int32_t check_clk(struct pwm_clk clk)
 
 int32_t clk_gate(void *base, uint8_t ch, bool pass)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -44,19 +47,137 @@ int32_t clk_gate(void *base, uint8_t ch, bool pass)
 
 int32_t clk_config(void *base, uint8_t ch, struct pwm_clk clk)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
     if(check_clk(clk))
         return -EINVAL;
 
-    writel(base + PCCRxy_OFFSET(ch), PCCRxy_VALUE(clk.src, clk.div));
+    // avoid needless reconfiguration of running partner channel
+    uint32_t value = PCCRxy_VALUE(clk.src, clk.div);
+    if(readl_relaxed(base + PCCRxy_OFFSET(ch)) != value)
+        writel(base + PCCRxy_OFFSET(ch), value);
     
     return 0;
 }
 
+/**
+ * @brief Split total divider into shared divider (2^div) and pre-scaler
+ *
+ */
+static bool split_div(uint32_t total, uint8_t div, uint8_t *pre)
+{
+    if(total & (BIT(div) - 1))
+        return false;
+
+    if((total >> div) > PWM_PRESCAL_K_MASK + 1)
+        return false;
+
+    *pre = (total >> div) - 1;
+    return true;
+}
+
+int32_t clk_arbitrate(void *base, uint8_t ch, struct pwm_clk clk, uint8_t pre,
+                      struct clk_plan *plan)
+{
+    if(check_ch(ch))
+        return -EINVAL;
+
+    if(check_clk(clk))
+        return -EINVAL;
+
+    if(!plan)
+        return -EFAULT;
+
+    uint8_t partner = ch ^ 1;
+    uint32_t pccr = readl_relaxed(base + PCCRxy_OFFSET(ch));
+    uint32_t per = readl_relaxed(base + PER_OFFSET);
+    uint32_t cer = readl_relaxed(base + CER_OFFSET);
+
+    struct pwm_clk cur = {
+        .src = IS_SET(pccr, PWM_CLK_SRC_SEL) ? APB0 : HOSC,
+        .div = GET_CLK_DIV(pccr)
+    };
+
+    plan->clk = clk;
+    plan->pre = pre;
+    plan->partner = IS_SET(per, PWMx_EN(partner)) || IS_SET(cer, CAPx_EN(partner));
+    plan->partner_changed = false;
+    plan->partner_pre = 0;
+
+    if(plan->partner) {
+        uint32_t pcr = readl_relaxed(base + PWM_REG_OFFSET(PCR_OFFSET, partner));
+        plan->partner_pre = GET_PWM_PRESCALER(pcr);
+
+        // partner counter clock can't be kept on another source
+        if(cur.src != clk.src || cur.div > DIV_256)
+            return -EBUSY;
+
+        uint32_t own_total = BIT(clk.div) * (pre + 1);
+        uint32_t partner_total = BIT(cur.div) * (plan->partner_pre + 1);
+
+        // prefer current divider, so partner is not touched at all
+        bool found = false;
+        for(int8_t i = -1; i <= DIV_256 && !found; i++) {
+            uint8_t div = (i < 0) ? (uint8_t)cur.div : (uint8_t)i;
+            uint8_t own_pre, partner_pre;
+
+            if(!split_div(own_total, div, &own_pre) ||
+               !split_div(partner_total, div, &partner_pre))
+                continue;
+
+            plan->clk.div = div;
+            plan->pre = own_pre;
+            plan->partner_changed = (partner_pre != plan->partner_pre);
+            plan->partner_pre = partner_pre;
+            found = true;
+        }
+
+        if(!found)
+            return -EBUSY;
+    }
+
+    plan->pccr_changed = (pccr != PCCRxy_VALUE(plan->clk.src, plan->clk.div));
+
+    return 0;
+}
+
+void clk_plan_stage(struct rw_txn *txn, uint8_t ch, const struct clk_plan *plan)
+{
+    if(plan->pccr_changed)
+        rw_txn_write(txn, PCCRxy_OFFSET(ch), PCCRxy_VALUE(plan->clk.src, plan->clk.div));
+
+    if(plan->partner_changed)
+        rw_txn_field(txn, PWM_REG_OFFSET(PCR_OFFSET, ch ^ 1), PWM_PRESCAL_K_MASK,
+                     plan->partner_pre);
+
+    rw_txn_field(txn, PWM_REG_OFFSET(PCR_OFFSET, ch), PWM_PRESCAL_K_MASK, plan->pre);
+}
+
+int32_t clk_pair_config(void *base, uint8_t ch, struct pwm_clk clk, uint8_t pre)
+{
+    RW_TRACE_API();
+    struct clk_plan plan;
+
+    int32_t ret = clk_arbitrate(base, ch, clk, pre, &plan);
+    if(ret)
+        return ret;
+
+    struct rw_txn txn;
+    rw_txn_begin(&txn, base);
+    clk_plan_stage(&txn, ch, &plan);
+
+    ret = rw_txn_commit(&txn);
+    if(ret)
+        return ret;
+
+    return timebase_update(base, ch, plan.clk, plan.pre);
+}
+
 int32_t get_clk_config(void *base, uint8_t ch, struct pwm_clk *clk)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -83,10 +204,11 @@ int32_t get_clk_config(void *base, uint8_t ch, struct pwm_clk *clk)
 
 int32_t set_prescaler(void *base, uint8_t ch, uint8_t pre)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
-    uint32_t reg = readl(base + PWM_REG_OFFSET(PCR_OFFSET, ch));
+    uint32_t reg = readl_relaxed(base + PWM_REG_OFFSET(PCR_OFFSET, ch));
     SET_PWM_PRESCALE(reg, pre);
     writel(base + PWM_REG_OFFSET(PCR_OFFSET, ch), reg);
 
@@ -95,6 +217,7 @@ int32_t set_prescaler(void *base, uint8_t ch, uint8_t pre)
 
 int32_t get_prescaler(void *base, uint8_t ch, uint8_t *pre)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -11,14 +11,197 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <time.h>
 #include "soc.h"
+#include "trace.h"
+#include "rw.h"
+#include "registers.h"
+#include "bitops.h"
+#include "timebase.h"
+#include "irq.h"
 #include "config.h"
 
+/**
+ * @brief Clock sources in common time unit (1/CALC_SCALE nS).
+ *        CALC_SCALE is smallest value which makes (NSEC_IN_SEC / freq) integer
+ *        for both sources (41.67 nS for HOSC, 10 nS for APB0)
+ */
+#define CALC_SCALE          3UL
+#define CALC_MAX_CYCLES     (GET_PWM_ENTIRE(0xFFFFFFFF) + 1UL)
+
+static const struct {
+    enum clk_src src;
+    uint32_t scale;             // clock period in (1/CALC_SCALE) nS
+} calc_src[] = {
+    {HOSC, CALC_SCALE * NSEC_IN_SEC / HOSC_FREQ},
+    {APB0, CALC_SCALE * NSEC_IN_SEC / APB0_FREQ},
+};
+
+/**
+ * @brief Every total divider (div * (pre + 1)) is searched in ascending order
+ *        without duplicates: DIV_1 with pre [0, 255] and then DIV_2 ... DIV_256
+ *        with pre [128, 255] (segments). Lower pre-scalers of higher dividers
+ *        are already covered by lower dividers.
+ */
+#define CALC_PRE_SIZE       (PWM_PRESCAL_K_MASK + 1)
+
+/**
+ * @brief floor(2^32 / (pre + 1)) for pre [0, 255] (UINT32_MAX for 1), built
+ *        on first pwm_calc()
+ * @note floor(t / (pre + 1)) is then one 32x32->64 multiply and at most one
+ *       correction step (no division per divider). Concurrent first calls
+ *       write same values
+ */
+static uint32_t calc_recip[CALC_PRE_SIZE];
+
+static void calc_recip_init(void)
+{
+    if(calc_recip[CALC_PRE_SIZE - 1])
+        return;
+
+    calc_recip[0] = UINT32_MAX;
+    for(uint32_t m = 2; m <= CALC_PRE_SIZE; m++)
+        calc_recip[m - 1] = (uint32_t)((1ULL << 32) / m);
+}
+
+/**
+ * @brief floor(t / m) and t % m, m [1, 256]
+ * @note Estimate is floor or one below it, correction is branchless as
+ *       remainders are random in search loop
+ */
+static inline uint32_t calc_divmod(uint32_t t, uint32_t m, uint32_t *rem)
+{
+    uint32_t q = ((uint64_t)t * calc_recip[m - 1]) >> 32;
+    uint32_t r = t - q * m;
+    uint32_t fix = (r >= m);
+
+    *rem = r - (m & -fix);
+    return q + fix;
+}
+
+/**
+ * @brief Best configuration found so far
+ *
+ */
+struct calc_best {
+    uint64_t err;               // period error in (1/CALC_SCALE) nS
+    uint32_t cycles;
+    uint8_t src;                // index of calc_src
+    uint8_t div;
+    uint8_t pre;
+};
+
+/**
+ * @brief Account cycles of total divider m << div, rounded result is clamped
+ *        to counter range (same as rounding target / q and clamping it)
+ * @return uint64_t Error of this divider
+ */
+static uint64_t calc_try(struct calc_best *best, uint64_t target, uint64_t q, uint64_t cycles,
+                     uint8_t src, uint8_t div, uint32_t m)
+{
+    if(cycles < 1)
+        cycles = 1;
+    if(cycles > CALC_MAX_CYCLES)
+        cycles = CALC_MAX_CYCLES;
+
+    uint64_t actual = cycles * q;
+    uint64_t err = (actual > target) ? actual - target : target - actual;
+
+    if(err < best->err || (err == best->err && cycles > best->cycles)) {
+        best->err = err;
+        best->cycles = cycles;
+        best->src = src;
+        best->div = div;
+        best->pre = m - 1;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Largest floor remainder (lo) and distance to next multiple (hi), in
+ *        steps, which still reach error err (-1: none). Both are below 256
+ *        (m), so limits are clamped to 32bit
+ */
+static void calc_limits(uint64_t err, uint64_t step, uint64_t r, int32_t *lo, int32_t *hi)
+{
+    uint64_t l = (err >= r) ? (err - r) / step : 0;
+    uint64_t h = (err >= UINT64_MAX - r) ? UINT64_MAX : (err + r) / step;
+
+    *lo = (err < r) ? -1 : (l > CALC_PRE_SIZE) ? CALC_PRE_SIZE : (int32_t)l;
+    *hi = (h > CALC_PRE_SIZE) ? CALC_PRE_SIZE : (int32_t)h;
+}
+
+/**
+ * @brief Search total dividers m << div, m [from, 256] of one source
+ * @return true once larger dividers can't improve result (exact match or
+ *         single cycle longer than target)
+ * @note t = floor(target / step), r = target % step. Floor multiple of m is
+ *       rem * step + r below target and next one (m - rem) * step - r above
+ *       it, so only rem = t % m (32bit) is compared against limits of best
+ *       error, which are refreshed only when best error changes
+ */
+static bool calc_segment(struct calc_best *best, uint64_t target, uint8_t src,
+                         uint8_t div, uint32_t from, uint32_t t, uint64_t r)
+{
+    uint64_t step = (uint64_t)calc_src[src].scale << div;
+    uint32_t to = (t < CALC_PRE_SIZE) ? t : CALC_PRE_SIZE;
+    int32_t lo_lim, hi_lim;
+
+    calc_limits(best->err, step, r, &lo_lim, &hi_lim);
+    for(uint32_t m = from; m <= to; m++) {
+        uint32_t u;
+        uint32_t c = calc_divmod(t, m, &u);
+        int32_t rem = u;
+
+        // neither neighbour multiple can reach best error (equal one may win on cycles)
+        if(rem > lo_lim && (int32_t)m - rem > hi_lim)
+            continue;
+
+        // nearest of floor and floor + 1, tie to more cycles
+        uint64_t below = rem * step + r;
+        uint64_t above = (m - rem) * step - r;
+        uint64_t prev = best->err;
+        uint64_t err = calc_try(best, target, step * m, (below >= above) ? c + 1ULL : c,
+                                src, div, m);
+
+        // exact match, higher dividers only reduce resolution
+        if(!err)
+            return true;
+        if(best->err != prev)
+            calc_limits(best->err, step, r, &lo_lim, &hi_lim);
+    }
+
+    // single cycle is already longer than target (m > t), error only grows
+    if(to < CALC_PRE_SIZE) {
+        uint32_t m = (to + 1 > from) ? to + 1 : from;
+        calc_try(best, target, step * m, 1, src, div, m);
+        return true;
+    }
+
+    return false;
+}
+
 int32_t pwm_min_max_period(uint64_t *max_ns, uint64_t *min_ns)
 {
     if(!max_ns | !min_ns)
         return -EFAULT;
 
+    uint32_t min_scale = calc_src[0].scale;
+    uint32_t max_scale = calc_src[0].scale;
+    for(size_t i = 1; i < sizeof(calc_src) / sizeof(calc_src[0]); i++) {
+        if(calc_src[i].scale < min_scale)
+            min_scale = calc_src[i].scale;
+        if(calc_src[i].scale > max_scale)
+            max_scale = calc_src[i].scale;
+    }
+
+    // single cycle without division, all cycles with maximum division
+    *min_ns = min_scale / CALC_SCALE;
+    // 64bit from first operand, unsigned long is 32bit on target
+    *max_ns = ((uint64_t)CALC_MAX_CYCLES * (BIT(DIV_256) * (PWM_PRESCAL_K_MASK + 1)) *
+               max_scale) / CALC_SCALE;
+
     return 0;
 }
 
@@ -27,126 +210,281 @@ int32_t pwm_clk_period(const struct pwm_config *config, uint64_t *period_ns)
     if(!config | !period_ns)
         return -EFAULT;
 
-    if(check_clk(config->clk))
+    struct pwm_timebase tb;
+    if(timebase_init(&tb, config->clk, config->pre))
         return -EINVAL;
 
-    uint32_t clk_freq = (config->clk.src == APB0 ? APB0_FREQ : HOSC_FREQ);
-    uint16_t divider = ( 1 << config->clk.div );
-    *period_ns = ( NSEC_IN_SEC / clk_freq ) * (1 + config->pre) * divider;
+    // rounded, use timebase for sub nS accuracy
+    *period_ns = tb_cycles_to_ns(&tb, 1);
     
     return 0;
 }
 
 int32_t get_pwm_freq(void *p, uint8_t ch, uint64_t *freq_hz)
 {
+    RW_TRACE_API();
     if(!freq_hz)
         return -EFAULT;
 
     int32_t ret;
-    struct pwm_config config;
-    ret = get_pwm_config(p, ch, &config);
+    struct pwm_timebase tb;
+    ret = timebase_get(p, ch, &tb);
     if(ret)
         return ret;
 
-    uint64_t period_ns;
-    ret = pwm_clk_period(&config, &period_ns);
+    struct pwm_period period;
+    ret = get_period(p, ch, &period);
     if(ret)
         return ret;
 
-    *freq_hz = NSEC_IN_SEC / (period_ns * (config.period.entire + 1));
+    *freq_hz = tb_cycles_to_hz(&tb, period.entire + 1);
 
     return 0;
 }
 
 int32_t pwm_calc(uint64_t period_ns, uint8_t duty_cycle, struct pwm_config *config)
 {
-    (void)period_ns;
-    (void)duty_cycle;
-    (void)config;
+    if(!config)
+        return -EFAULT;
+
+    if(!period_ns || duty_cycle > 100)
+        return -EINVAL;
+
+    uint64_t min_ns, max_ns;
+    pwm_min_max_period(&max_ns, &min_ns);
+    if(period_ns < min_ns || period_ns > max_ns)
+        return -ERANGE;
+
+    calc_recip_init();
+
+    uint64_t target = period_ns * CALC_SCALE;
+    struct calc_best best = {.err = UINT64_MAX};
+
+    for(uint8_t s = 0; s < sizeof(calc_src) / sizeof(calc_src[0]); s++) {
+        uint32_t scale = calc_src[s].scale;
+        uint64_t min_total = target / (scale * CALC_MAX_CYCLES);
+        // only 64bit division of source, segments shift it
+        uint64_t t0 = target / scale;
+
+        for(uint8_t div = DIV_1; div <= DIV_256; div++) {
+            uint32_t m = (min_total + BIT(div) - 1) >> div;
+            uint32_t m_lo = (div == DIV_1) ? 1 : CALC_PRE_SIZE / 2 + 1;
+            if(m < m_lo)
+                m = m_lo;
+
+            // cycles of every divider of segment exceed counter
+            uint64_t t = t0 >> div;
+            if(m > CALC_PRE_SIZE || t > UINT32_MAX)
+                continue;
+
+            /**
+             * @brief Every period of segment is multiple of step, so distance
+             *        of target to closest multiple bounds error of segment.
+             *        Equal error only wins with more cycles than best
+             */
+            uint64_t step = (uint64_t)scale << div;
+            uint64_t r = target - t * step;
+            uint64_t bound = (r < step - r) ? r : step - r;
+            if(bound > best.err || (bound == best.err && t / m + 1 <= best.cycles))
+                continue;
+
+            if(calc_segment(&best, target, s, div, m, t, r))
+                break;
+        }
+    }
+
+    config->clk.src = calc_src[best.src].src;
+    config->clk.div = best.div;
+    config->pre = best.pre;
+    config->period.entire = best.cycles - 1;
+    config->period.act = (config->period.entire * duty_cycle) / 100;
+
     return 0;
 }
 
 int32_t get_pwm_config(void *p, uint8_t ch, struct pwm_config *config)
 {
-    int32_t ret;
-    
+    RW_TRACE_API();
+    if(check_ch(ch))
+        return -EINVAL;
+
     if(!config)
         return -EFAULT;
 
-    ret = is_pwm_en(p, ch, &config->en);
-    if(ret)
-        return ret;
+    uint32_t per = readl_relaxed(p + PER_OFFSET);
+    uint32_t pccr = readl_relaxed(p + PCCRxy_OFFSET(ch));
 
-    ret = get_period(p, ch, &config->period);
-    if(ret)
-        return ret;
+    // PCR and PPR are adjacent
+    uint32_t blk[2];
+    readsl(p + PWM_REG_OFFSET(PCR_OFFSET, ch), blk, 2);
 
-    ret = get_clk_config(p, ch, &config->clk);
-    if(ret)
-        return ret;
+    if(GET_CLK_DIV(pccr) > DIV_256)
+        return -EINVAL;
 
-    ret = get_prescaler(p, ch, &config->pre);
-    if(ret)
-        return ret;
+    config->en = IS_SET(per, PWMx_EN(ch));
+    config->clk.src = IS_SET(pccr, PWM_CLK_SRC_SEL) ? APB0 : HOSC;
+    config->clk.div = GET_CLK_DIV(pccr);
+    config->pre = GET_PWM_PRESCALER(blk[0]);
+    config->state = IS_SET(blk[0], PWM_ACT_STA) ? ACT_HIGH : ACT_LOW;
+    config->period.act = GET_PWM_ACT(blk[1]);
+    config->period.entire = GET_PWM_ENTIRE(blk[1]);
 
-    // ToDo: act_state must be implemented
     return 0;
 }
 
+/**
+ * @brief Stage registers of PWM channel, in the same order as clk_gate(),
+ *        clk_pair_config(), set_period(), set_act_state() and pwm_en()
+ *
+ */
+static void stage_pwm_config(struct rw_txn *txn, uint8_t ch, const struct pwm_config *config,
+                             const struct clk_plan *plan)
+{
+    if(config->en)
+        rw_txn_bit(txn, PCGR_OFFSET, PWMx_CLK_GATING(ch), true);
+
+    clk_plan_stage(txn, ch, plan);
+
+    uint32_t ppr = 0;
+    SET_PWM_PERIOD(ppr, config->period.entire, config->period.act);
+    rw_txn_write(txn, PWM_REG_OFFSET(PPR_OFFSET, ch), ppr);
+
+    rw_txn_bit(txn, PWM_REG_OFFSET(PCR_OFFSET, ch), PWM_ACT_STA,
+               to_act_state(config->state));
+
+    if(config->en)
+        rw_txn_bit(txn, PER_OFFSET, PWMx_EN(ch), true);
+}
+
 int32_t set_pwm_config(void *p, uint8_t ch, const struct pwm_config *config)
 {
+    RW_TRACE_API();
     int32_t ret;
     
     if(!config)
         return -EFAULT;
 
+    if(check_ch(ch) || check_clk(config->clk) || check_period(config->period))
+        return -EINVAL;
+
     // ToDo: Check if capture mode is enabled or not!
 
+    // keep partner channel (ch ^ 1) running on shared PCCRxy
+    struct clk_plan plan;
+    ret = clk_arbitrate(p, ch, config->clk, config->pre, &plan);
+    if(ret)
+        return ret;
+
     /**
-     * @brief In case of disable, we need clock to be gated after
+     * @brief All registers of channel are updated in single transaction.
+     *        In case of disable, we need clock to be gated after
      *        PWM cycle is finished! So we disable it at the end
      */
-    if(config->en) {
-        ret = clk_gate(p, ch, true);
-        if(ret)
-            return ret;
-    }
+    struct rw_txn txn;
+    rw_txn_begin(&txn, p);
+    stage_pwm_config(&txn, ch, config, &plan);
 
-    ret = clk_config(p, ch, config->clk);
+    ret = rw_txn_commit(&txn);
     if(ret)
         return ret;
 
-    ret = set_period(p, ch, config->period);
-    if(ret)
-        return ret;
+    timebase_update(p, ch, plan.clk, plan.pre);
 
-    ret = set_prescaler(p, ch, config->pre);
-    if(ret)
-        return ret;
+    /**
+     * @brief In case of disabling, clock is gated after PWM is disabled.
+     *        Check pwm_en() for more information. On -ETIMEDOUT channel is
+     *        disabled anyway, so clock is still gated and timeout reported
+     */
+    if(!config->en) {
+        ret = pwm_en(p, ch, false);
+        if(ret && ret != -ETIMEDOUT)
+            return ret;
 
-    ret = set_act_state(p, ch, config->state);
+        int32_t err = clk_gate(p, ch, false);
+        if(err)
+            return err;
+    }
+
+    return ret;
+}
+
+int32_t set_pwm_pair_config(void *p, uint8_t ch, const struct pwm_config *config,
+                            uint32_t dead_ns)
+{
+    RW_TRACE_API();
+    int32_t ret;
+
+    if(!config)
+        return -EFAULT;
+
+    if(check_ch(ch) || (ch & 1) || check_clk(config->clk) || check_period(config->period))
+        return -EINVAL;
+
+    struct clk_plan plan;
+    ret = clk_arbitrate(p, ch, config->clk, config->pre, &plan);
     if(ret)
         return ret;
 
-    ret = pwm_en(p, ch, config->en);
+    // dead zone counts PWMxy clock of applied plan (after divider, before pre-scaler)
+    struct pwm_timebase tb;
+    ret = timebase_init(&tb, plan.clk, 0);
     if(ret)
         return ret;
 
+    uint64_t intv = tb_ns_to_cycles(&tb, dead_ns);
+    if(intv > PWM_DZ_INTV_MASK)
+        return -ERANGE;
+
     /**
-     * @brief In case of disabling, clock is gated after PWM is disabled.
-     *        Check pwm_en() for more information
+     * @brief Both outputs in single transaction: gating, then dead zone, then
+     *        ch + 1 polarity, then ch registers and finally one PER write which
+     *        starts ch and ch + 1 together. rw_txn_commit() writes registers in
+     *        order of first staging, so PCR(ch + 1) must be staged before
+     *        stage_pwm_config() creates PER entry
      */
-    if(!config->en) {
-        ret = clk_gate(p, ch, false);
-        if(ret)
-            return ret;
+    struct rw_txn txn;
+    rw_txn_begin(&txn, p);
+    if(config->en) {
+        rw_txn_bit(&txn, PCGR_OFFSET, PWMx_CLK_GATING(ch + 1), true);
+        rw_txn_write(&txn, PDZCRxy_OFFSET(ch), PDZCRxy_VALUE(true, intv));
     }
 
-    return 0;
+    rw_txn_bit(&txn, PWM_REG_OFFSET(PCR_OFFSET, ch + 1), PWM_ACT_STA,
+               to_act_state(config->state));
+
+    stage_pwm_config(&txn, ch, config, &plan);
+
+    if(config->en)
+        rw_txn_bit(&txn, PER_OFFSET, PWMx_EN(ch + 1), true);
+
+    ret = rw_txn_commit(&txn);
+    if(ret)
+        return ret;
+
+    timebase_update(p, ch, plan.clk, plan.pre);
+
+    if(config->en)
+        return 0;
+
+    // disable after current cycle of ch, then gate clocks and drop dead zone
+    // (also on -ETIMEDOUT, ch is disabled anyway and timeout is reported)
+    ret = pwm_en(p, ch, false);
+    if(ret && ret != -ETIMEDOUT)
+        return ret;
+
+    rw_txn_begin(&txn, p);
+    rw_txn_bit(&txn, PER_OFFSET, PWMx_EN(ch + 1), false);
+    rw_txn_bit(&txn, PCGR_OFFSET, PWMx_CLK_GATING(ch), false);
+    rw_txn_bit(&txn, PCGR_OFFSET, PWMx_CLK_GATING(ch + 1), false);
+    rw_txn_write(&txn, PDZCRxy_OFFSET(ch), PDZCRxy_VALUE(false, 0));
+
+    int32_t err = rw_txn_commit(&txn);
+    return err ? err : ret;
 }
 
 int32_t set_pwm_duty(void *p, uint8_t ch, uint8_t duty)
 {
+    RW_TRACE_API();
     int32_t ret;
     struct pwm_period period;
 
@@ -165,11 +503,15 @@ int32_t set_pwm_duty(void *p, uint8_t ch, uint8_t duty)
 
 int32_t set_cap_config(void *p, uint8_t ch, const struct cap_config *config)
 {
+    RW_TRACE_API();
     int32_t ret;
 
     if(!config)
         return -EFAULT;
 
+    if(check_clk(config->clk))
+        return -EINVAL;
+
     // Don't touch if PWM is enabled
     bool pwm = false;
     ret = is_pwm_en(p, ch, &pwm);
@@ -179,45 +521,54 @@ int32_t set_cap_config(void *p, uint8_t ch, const struct cap_config *config)
     if(pwm)
         return -EBUSY;
 
-    ret = clk_gate(p, ch, config->rising & config->falling);
-    if(ret)
-        return ret;
-
-    ret = clk_config(p, ch, config->clk);
-    if(ret)
-        return ret;
-
-    ret = set_prescaler(p, ch, config->pre);
-    if(ret)
-        return ret;
-
-    ret = cap_en(p, ch, config->rising, config->falling);
+    // keep partner channel (ch ^ 1) running on shared PCCRxy
+    struct clk_plan plan;
+    ret = clk_arbitrate(p, ch, config->clk, config->pre, &plan);
     if(ret)
         return ret;
 
-    ret = clear_cap_irq(p, ch, true, true);
+    /**
+     * @brief Same sequence as clk_gate(), clk_pair_config(),
+     *        cap_en() and clear_cap_irq() merged into single transaction.
+     *        CRLF/CFLF and CISR are write-1-to-clear
+     */
+    struct rw_txn txn;
+    rw_txn_begin(&txn, p);
+    rw_txn_bit(&txn, PCGR_OFFSET, PWMx_CLK_GATING(ch), config->rising & config->falling);
+    clk_plan_stage(&txn, ch, &plan);
+    rw_txn_bit(&txn, CER_OFFSET, CAPx_EN(ch), config->rising | config->falling);
+    rw_txn_field(&txn, PWM_REG_OFFSET(CCR_OFFSET, ch),
+                 BIT(CRTE) | BIT(CFTE) | BIT(CRLF) | BIT(CFLF),
+                 (config->rising ? BIT(CRTE) : 0) | (config->falling ? BIT(CFTE) : 0) |
+                 BIT(CRLF) | BIT(CFLF));
+    rw_txn_write(&txn, CISR_OFFSET, BIT(CRISx(ch)) | BIT(CFISx(ch)));
+
+    ret = rw_txn_commit(&txn);
     if(ret)
         return ret;
 
-    return 0;
+    return timebase_update(p, ch, plan.clk, plan.pre);
 }
 
 int32_t cap_blocking(void *p, uint8_t ch, struct cap_result_raw *result)
 {
+    RW_TRACE_API();
     if(!result)
         return -EFAULT;
 
+    if(check_ch(ch))
+        return -EINVAL;
+
     bool loop = true;
     while( loop ) {
-        bool cflf;
-        cap_cflf(p, ch, &cflf);
-
-        bool crlf;
-        cap_crlf(p, ch, &crlf);
-
-        if(crlf & cflf) {
-            cap_rising_lock(p, ch, &result->off_cycles);
-            cap_falling_lock(p, ch, &result->on_cycles);
+        uint32_t ccr = readl(p + PWM_REG_OFFSET(CCR_OFFSET, ch));
+
+        if(IS_SET(ccr, CRLF) & IS_SET(ccr, CFLF)) {
+            // CRLR and CFLR are adjacent
+            uint32_t lock[2];
+            readsl(p + PWM_REG_OFFSET(CRLR_OFFSET, ch), lock, 2);
+            result->off_cycles = CRLR(lock[0]);
+            result->on_cycles = CFLR(lock[1]);
             clear_cap_irq(p, ch, true, true);
             loop = false;
         }
@@ -227,31 +578,109 @@ int32_t cap_blocking(void *p, uint8_t ch, struct cap_result_raw *result)
     return 0;
 }
 
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * NSEC_IN_SEC + ts.tv_nsec;
+}
+
+int32_t cap_wait_event(void *p, uint8_t ch, struct cap_event *ev,
+                       uint32_t timeout_ms, int cancel_fd)
+{
+    RW_TRACE_API();
+    if(!ev)
+        return -EFAULT;
+
+    if(check_ch(ch))
+        return -EINVAL;
+
+    int fd = pwm_irq_fd(p);
+    if(fd < 0)
+        return -ENODEV;
+
+    // CIER bits of channel on entry (e.g reactor serves it too)
+    uint32_t cier = readl(p + CIER_OFFSET);
+    int32_t ret = en_cap_irq(p, ch, true, true);
+    if(ret)
+        return ret;
+
+    uint32_t done = BIT(CRISx(ch)) | BIT(CFISx(ch));
+    uint64_t deadline = now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    for(;;) {
+        if((readl(p + CISR_OFFSET) & done) == done) {
+            // CRLR and CFLR are adjacent
+            uint32_t lock[2];
+            readsl(p + PWM_REG_OFFSET(CRLR_OFFSET, ch), lock, 2);
+            ev->ts_ns = now_ns();
+            ev->ch = ch;
+            ev->raw.off_cycles = CRLR(lock[0]);
+            ev->raw.on_cycles = CFLR(lock[1]);
+            ret = clear_cap_irq(p, ch, true, true);
+            break;
+        }
+
+        uint64_t now = now_ns();
+        if(now >= deadline) {
+            ret = -ETIMEDOUT;
+            break;
+        }
+
+        // interrupt line is shared, event may belong to other channel
+        ret = pwm_irq_wait(fd, cancel_fd, (deadline - now + 999999) / 1000000, NULL);
+        if(ret && ret != -ETIMEDOUT)
+            break;
+    }
+
+    // keep shared interrupt line quiet while nobody waits, restore bits set on entry
+    en_cap_irq(p, ch, IS_SET(cier, CRIEx(ch)), IS_SET(cier, CFIEx(ch)));
+
+    // count is informative, window may have none yet
+    if(!ret && pwm_irq_count(p, &ev->irq_count))
+        ev->irq_count = 0;
+
+    return ret;
+}
+
+int32_t cap_wait(void *p, uint8_t ch, struct cap_result_raw *result,
+                 uint32_t timeout_ms, int cancel_fd)
+{
+    RW_TRACE_API();
+    if(!result)
+        return -EFAULT;
+
+    struct cap_event ev;
+    int32_t ret = cap_wait_event(p, ch, &ev, timeout_ms, cancel_fd);
+    if(!ret)
+        *result = ev.raw;
+
+    return ret;
+}
+
 int32_t result_to_ns(void *p, uint8_t ch, 
                      const struct cap_result_raw *raw,
                      struct cap_result *result)
 {
+    RW_TRACE_API();
     if(!raw || !result)
         return -EFAULT;
 
-    int32_t ret;
-    struct pwm_config config;
-    ret = get_pwm_config(p, ch, &config);
+    // no register access as long as clock configuration is not changed
+    struct pwm_timebase tb;
+    int32_t ret = timebase_get(p, ch, &tb);
     if(ret)
         return ret;
 
-    // how long each cycle is?
-    uint64_t clk_period;
-    ret = pwm_clk_period(&config, &clk_period);
-
-    result->on_ns = raw->on_cycles * clk_period;
-    result->off_ns = raw->off_cycles * clk_period;
+    result->on_ns = tb_cycles_to_ns(&tb, raw->on_cycles);
+    result->off_ns = tb_cycles_to_ns(&tb, raw->off_cycles);
 
     return 0;
 }
 
 int32_t cap_max_duration(void *p, uint8_t ch, uint64_t *max_ns)
 {
+    RW_TRACE_API();
     struct cap_result_raw raw = {.on_cycles = 65535 };
     struct cap_result res;
 
@@ -0,0 +1,123 @@
+/**
+ * @file group.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Synchronized multi channel update using PWM group registers
+ * @version 0.1
+ * @date 2024-10-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "soc.h"
+#include "trace.h"
+#include "registers.h"
+#include "bitops.h"
+#include "irq.h"
+#include "group.h"
+
+int32_t pwm_group_init(struct pwm_group *g, void *base, uint8_t grp, uint8_t mask)
+{
+    RW_TRACE_API();
+    if(!g || !base)
+        return -EFAULT;
+
+    if(grp >= PWM_GROUP || !mask)
+        return -EINVAL;
+
+    g->base = base;
+    g->grp = grp;
+    g->mask = mask;
+    g->en = -1;
+    rw_txn_begin(&g->txn, base);
+
+    writel(base + PGRx_OFFSET(grp), (mask & PWMG_CS_MASK) | BIT(PWMG_EN));
+
+    return 0;
+}
+
+int32_t pwm_group_period(struct pwm_group *g, uint8_t ch, struct pwm_period period)
+{
+    if(!g)
+        return -EFAULT;
+
+    if(check_ch(ch) || !IS_SET(g->mask, ch))
+        return -EINVAL;
+
+    if(check_period(period))
+        return -EINVAL;
+
+    uint32_t ppr = 0;
+    SET_PWM_PERIOD(ppr, period.entire, period.act);
+    rw_txn_write(&g->txn, PWM_REG_OFFSET(PPR_OFFSET, ch), ppr);
+
+    return 0;
+}
+
+int32_t pwm_group_enable(struct pwm_group *g, bool en)
+{
+    if(!g)
+        return -EFAULT;
+
+    g->en = en;
+
+    return 0;
+}
+
+int32_t pwm_group_commit(struct pwm_group *g)
+{
+    RW_TRACE_API();
+    if(!g)
+        return -EFAULT;
+
+    uint32_t pgr = (g->mask & PWMG_CS_MASK) | BIT(PWMG_EN);
+    int32_t ret = 0;
+
+    /**
+     * @brief Enable is staged after periods, whatever order of calls was.
+     *        Group holds members (PGR CS | EN) while their clock passes and
+     *        PER arms them, hardware only runs channels with PER set. START
+     *        is written alone after that, so it releases all members at once
+     */
+    if(g->en == 1) {
+        rw_txn_write(&g->txn, PGRx_OFFSET(g->grp), pgr);
+        rw_txn_field(&g->txn, PCGR_OFFSET, g->mask, g->mask);
+        rw_txn_field(&g->txn, PER_OFFSET, g->mask, g->mask);
+    } else if(g->en == 0) {
+        /**
+         * @brief Members run in phase, so end of cycle of first one is end of
+         *        cycle of all (best effort, same as pwm_en()). Then group is
+         *        stopped, members disabled and their clock gated in reverse
+         *        order of enable. Members are disabled even on -ETIMEDOUT
+         */
+        uint8_t first = __builtin_ctz(g->mask);
+        bool cur = false;
+        if(pwm_irq_fd(g->base) >= 0 && !is_pwm_en(g->base, first, &cur) && cur)
+            ret = pwm_wait_cycle(g->base, first);
+
+        rw_txn_write(&g->txn, PGRx_OFFSET(g->grp), pgr);
+        rw_txn_field(&g->txn, PER_OFFSET, g->mask, 0);
+        rw_txn_field(&g->txn, PCGR_OFFSET, g->mask, 0);
+    }
+
+    int32_t err = rw_txn_commit(&g->txn);
+    if(!err && g->en == 1)
+        writel(g->base + PGRx_OFFSET(g->grp), pgr | BIT(PWMG_START));
+
+    // start over (also after failure, nothing is written then)
+    rw_txn_begin(&g->txn, g->base);
+    g->en = -1;
+
+    return err ? err : ret;
+}
+
+int32_t pwm_group_release(struct pwm_group *g)
+{
+    RW_TRACE_API();
+    if(!g)
+        return -EFAULT;
+
+    writel(g->base + PGRx_OFFSET(g->grp), 0);
+    g->mask = 0;
+
+    return 0;
+}
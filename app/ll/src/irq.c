@@ -0,0 +1,188 @@
+/**
+ * @file irq.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief PWM interrupt delivered through UIO file descriptor
+ * @version 0.1
+ * @date 2024-10-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include "irq.h"
+
+#define IRQ_MAX_WINDOW      2
+
+/**
+ * @brief Interrupt file descriptor of one PWM register window
+ *
+ */
+struct irq_window {
+    void *base;
+    int fd;
+    int event_fd;               // sysfs event count of UIO device, -1 if none
+    uint32_t count;             // last event count read from fd
+    bool counted;               // count was read at least once
+};
+
+static struct irq_window windows[IRQ_MAX_WINDOW];
+static uint8_t nr_window;
+
+static struct irq_window *find_window(void *base)
+{
+    for(uint8_t i = 0; i < nr_window; i++)
+        if(windows[i].base == base)
+            return &windows[i];
+
+    return NULL;
+}
+
+/**
+ * @brief Open /sys/class/uio/uioN/event of UIO device node (as uio_helper does)
+ *
+ */
+static int open_event(int fd)
+{
+    struct stat st;
+    if(fstat(fd, &st) || !S_ISCHR(st.st_mode))
+        return -1;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/dev/char/%u:%u/event",
+             major(st.st_rdev), minor(st.st_rdev));
+
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+int32_t pwm_irq_attach(void *base, int fd)
+{
+    if(!base)
+        return -EFAULT;
+
+    if(fd < 0)
+        return -EINVAL;
+
+    // several waiters share one descriptor, read() must not block
+    int flags = fcntl(fd, F_GETFL);
+    if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK))
+        return -errno;
+
+    struct irq_window *w = find_window(base);
+    if(!w) {
+        if(nr_window == IRQ_MAX_WINDOW)
+            return -ENOMEM;
+        w = &windows[nr_window++];
+        w->base = base;
+    } else if(w->event_fd >= 0) {
+        close(w->event_fd);
+    }
+    w->fd = fd;
+    w->event_fd = open_event(fd);
+    w->count = 0;
+    w->counted = false;
+
+    return 0;
+}
+
+int32_t pwm_irq_detach(void *base)
+{
+    struct irq_window *w = find_window(base);
+    if(!w)
+        return -ENOENT;
+
+    if(w->event_fd >= 0)
+        close(w->event_fd);
+
+    // keep table packed
+    *w = windows[--nr_window];
+
+    return 0;
+}
+
+int pwm_irq_fd(void *base)
+{
+    struct irq_window *w = find_window(base);
+
+    return w ? w->fd : -1;
+}
+
+int32_t pwm_irq_wait(int fd, int cancel_fd, uint32_t timeout_ms, uint32_t *count)
+{
+    if(fd < 0)
+        return -EINVAL;
+
+    /**
+     * @brief Re-enable interrupt line (UIO irqcontrol). Drivers without
+     *        irqcontrol reject it, their interrupt line is never masked
+     */
+    uint32_t unmask = 1;
+    if(write(fd, &unmask, sizeof(unmask)) < 0 && errno != ENOSYS)
+        return -errno;
+
+    struct pollfd pfd[2] = {
+        {.fd = fd, .events = POLLIN},
+        {.fd = cancel_fd, .events = POLLIN},    // ignored by poll() if -1
+    };
+    int ret = poll(pfd, 2, (timeout_ms > INT32_MAX) ? -1 : (int)timeout_ms);
+    if(ret < 0)
+        return -errno;
+
+    if(ret == 0)
+        return -ETIMEDOUT;
+
+    if(pfd[1].revents)
+        return -ECANCELED;
+
+    // event can be consumed by another waiter in between (non blocking fd)
+    uint32_t cnt;
+    ssize_t n = read(fd, &cnt, sizeof(cnt));
+    if(n < 0 && errno != EAGAIN)
+        return -errno;
+
+    if(n == sizeof(cnt)) {
+        for(uint8_t i = 0; i < nr_window; i++)
+            if(windows[i].fd == fd) {
+                windows[i].count = cnt;
+                windows[i].counted = true;
+            }
+        if(count)
+            *count = cnt;
+    }
+
+    return 0;
+}
+
+int32_t pwm_irq_count(void *base, uint32_t *count)
+{
+    if(!count)
+        return -EFAULT;
+
+    struct irq_window *w = find_window(base);
+    if(!w)
+        return -ENOENT;
+
+    if(w->event_fd >= 0) {
+        char buf[16];
+        ssize_t n = pread(w->event_fd, buf, sizeof(buf) - 1, 0);
+        if(n > 0) {
+            buf[n] = 0;
+            w->count = strtoul(buf, NULL, 10);
+            w->counted = true;
+        }
+    }
+
+    if(!w->counted)
+        return -ENODATA;
+    *count = w->count;
+
+    return 0;
+}
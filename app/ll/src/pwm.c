@@ -8,11 +8,22 @@
  * @copyright Copyright (c) 2024
  * 
  */
+#include <time.h>
+
 #include "soc.h"
+#include "trace.h"
 #include "rw.h"
 #include "registers.h"
 #include "bitops.h"
 #include "pwm.h"
+#include "irq.h"
+#include "timebase.h"
+
+// Period interrupt can be late by scheduling latency
+#define PWM_WAIT_SLACK_NS       2000000ULL
+// Status poll interval without interrupt (bounded to period)
+#define PWM_POLL_MIN_NS         10000ULL
+#define PWM_POLL_MAX_NS         1000000ULL
 
  int32_t check_period(struct pwm_period period)
 {
@@ -26,6 +37,7 @@
 
  int32_t clk_bypass(void *base, uint8_t ch, bool bypass)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -36,6 +48,7 @@
 
  int32_t is_pwm_en(void *base, uint8_t ch, bool *en)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
     
@@ -48,25 +61,103 @@
     return 0;
 }
 
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+ int32_t pwm_wait_cycle(void *base, uint8_t ch)
+{
+    RW_TRACE_API();
+    if(check_ch(ch))
+        return -EINVAL;
+
+    struct pwm_timebase tb;
+    int32_t ret = timebase_get(base, ch, &tb);
+    if(ret)
+        return ret;
+
+    uint32_t reg = readl(base + PWM_REG_OFFSET(PPR_OFFSET, ch));
+    uint64_t period_ns = tb_cycles_to_ns(&tb, GET_PWM_ENTIRE(reg) + 1);
+    uint64_t deadline = now_ns() + 2 * period_ns + PWM_WAIT_SLACK_NS;
+
+    // drop stale end of cycle, then unmask it
+    writel(base + PISR_OFFSET, BIT(PISx(ch)));
+    rmwb(base + PIER_OFFSET, PCIEx(ch), true);
+
+    int fd = pwm_irq_fd(base);
+    uint64_t poll_ns = period_ns / 4;
+    if(poll_ns < PWM_POLL_MIN_NS)
+        poll_ns = PWM_POLL_MIN_NS;
+    if(poll_ns > PWM_POLL_MAX_NS)
+        poll_ns = PWM_POLL_MAX_NS;
+
+    ret = -ETIMEDOUT;
+    for(uint64_t now = now_ns(); now < deadline; now = now_ns()) {
+        if(IS_SET(readl(base + PISR_OFFSET), PISx(ch))) {
+            ret = 0;
+            break;
+        }
+
+        /**
+         * @brief Interrupt line is shared, other waiter may consume event.
+         *        So never sleep longer than one period before checking PISR
+         */
+        uint64_t slice = deadline - now;
+        if(fd >= 0) {
+            if(slice > period_ns + PWM_POLL_MAX_NS)
+                slice = period_ns + PWM_POLL_MAX_NS;
+            int32_t err = pwm_irq_wait(fd, -1, (slice + 999999) / 1000000, NULL);
+            if(err && err != -ETIMEDOUT) {
+                ret = err;
+                break;
+            }
+        } else {
+            if(slice > poll_ns)
+                slice = poll_ns;
+            struct timespec ts = {.tv_sec = slice / 1000000000ULL,
+                                  .tv_nsec = slice % 1000000000ULL};
+            nanosleep(&ts, NULL);
+        }
+    }
+
+    rmwb(base + PIER_OFFSET, PCIEx(ch), false);
+    writel(base + PISR_OFFSET, BIT(PISx(ch)));
+
+    return ret;
+}
+
  int32_t pwm_en(void *base, uint8_t ch, bool en)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
-    /* when disabling, wait for current cycle to end */
-    if(!en) {
-        bool cur;
+
+    /**
+     * when disabling, wait for current cycle to end. Only with interrupt
+     * descriptor, polling would burn up to two periods and RAM/file backends
+     * never set PISR. Channel is disabled even if wait times out, but the
+     * timeout is still reported
+     */
+    int32_t ret = 0;
+    if(!en && pwm_irq_fd(base) >= 0) {
+        bool cur = false;
         is_pwm_en(base, ch, &cur);
-        uint32_t reg = readl(base + PWM_REG_OFFSET(PPCNTR_OFFSET, ch));
-        while(cur & PPCNTR(reg));
+        if(cur)
+            ret = pwm_wait_cycle(base, ch);
     }
 
     rmwb(base + PER_OFFSET, PWMx_EN(ch), en);
 
-    return 0;
+    return ret;
 }
 
  int32_t set_period(void *base, uint8_t ch, struct pwm_period period)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
     
@@ -82,6 +173,7 @@
 
  int32_t get_period(void *base, uint8_t ch, struct pwm_period *period)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -98,6 +190,7 @@
 
  int32_t set_act_state(void *p, uint8_t ch, enum act_state state)
 {
+    RW_TRACE_API();
     if(check_ch(ch))
         return -EINVAL;
 
@@ -105,4 +198,33 @@
     rmwb(addr, PWM_ACT_STA, to_act_state(state));
 
     return 0;
-}
\ No newline at end of file
+}
+
+int32_t set_dead_zone(void *base, uint8_t ch, bool en, uint8_t intv)
+{
+    RW_TRACE_API();
+    if(check_ch(ch))
+        return -EINVAL;
+
+    writel(base + PDZCRxy_OFFSET(ch), PDZCRxy_VALUE(en, intv));
+
+    return 0;
+}
+
+int32_t pwm_duty_init(void *base, uint8_t ch, struct pwm_duty *duty)
+{
+    RW_TRACE_API();
+    if(check_ch(ch))
+        return -EINVAL;
+
+    if(!duty)
+        return -EFAULT;
+
+    duty->ppr = base + PWM_REG_OFFSET(PPR_OFFSET, ch);
+
+    uint32_t reg = readl(duty->ppr);
+    duty->entire = reg & ~GET_PWM_ACT(0xFFFFFFFF);
+    duty->scale = GET_PWM_ENTIRE(reg) + 1;
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file registers.cpp
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Compile time checks of registers.hpp descriptors (no code)
+ * @version 0.1
+ * @date 2024-10-17
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "registers.hpp"
+
+namespace t113::pwm {
+
+// Composed masks of multi field writes
+static_assert(composed<decltype(pcr<2>::prescal_k::make<19>()),
+                       decltype(pcr<2>::act_sta::make<1>())>::mask ==
+              (PWM_PRESCAL_K_MASK | BIT(PWM_ACT_STA)));
+static_assert(composed<decltype(ccr<3>::crte::make<1>()),
+                       decltype(ccr<3>::cfte::make<1>())>::mask == (BIT(CRTE) | BIT(CFTE)));
+static_assert(composed<decltype(cier<5>::crie::make<1>()),
+                       decltype(cier<5>::cfie::make<1>())>::mask ==
+              (BIT(CRIEx(5)) | BIT(CFIEx(5))));
+static_assert(compose(ccr<3>::crte::make<1>(), ccr<3>::capinv::make<1>()) ==
+              (BIT(CRTE) | BIT(CAPINV)));
+
+// Pending lock flags are not written back by modify()
+static_assert(modify_value(BIT(CRLF) | BIT(CFLF) | BIT(CFTE), ccr<1>::crte::make<1>()) ==
+              (BIT(CRTE) | BIT(CFTE)));
+static_assert(modify_value(BIT(CRLF) | BIT(CFLF), ccr<1>::crlf::make<1>()) == BIT(CRLF));
+
+// Only mentioned status flags are cleared
+static_assert(modify_value(0xFFFF, cisr<2>::cris::make<1>(), cisr<2>::cfis::make<1>()) ==
+              (BIT(CRISx(2)) | BIT(CFISx(2))));
+static_assert(modify_value(0xFF, pisr<6>::pis::make<1>()) == BIT(PISx(6)));
+
+// Plain registers keep not mentioned fields
+static_assert(modify_value(0xFFFFFFFF, pcr<0>::prescal_k::make<0>()) ==
+              (0xFFFFFFFF & ~PWM_PRESCAL_K_MASK));
+
+} // namespace t113::pwm
@@ -4,35 +4,403 @@
  * @brief Read / Write helper functions
  * @version 0.1
  * @date 2024-09-19
- * 
+ *
  * @copyright Copyright (c) 2024
- * 
+ *
  */
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "rw.h"
 #include "bitops.h"
+#include "soc.h"
+#include "registers.h"
+#include "trace.h"
 
-void writel(void* base, uint32_t value)
+#define RW_MAX_SHADOW       2
+#define RW_MAX_WINDOW       2
+
+/**
+ * @brief Shadow copy of one PWM register window
+ *
+ */
+struct rw_shadow {
+    uintptr_t base;
+    uint32_t regs[PWM_WINDOW_SIZE / 4];
+    struct rw_shadow_stats stats;
+};
+
+static struct rw_shadow shadows[RW_MAX_SHADOW];
+static uint8_t nr_shadow;
+
+/**
+ * @brief Clock configuration epochs of one mapped PWM register window
+ *
+ */
+struct rw_window {
+    uintptr_t base;
+    uint32_t clk_epoch[PWM_CHANNEL];
+};
+
+static struct rw_window windows[RW_MAX_WINDOW];
+static uint8_t nr_window;
+
+/**
+ * @brief Registers which are changed by hardware and must not be cached
+ *
+ */
+static bool is_volatile(uint32_t off)
+{
+    if(off == PISR_OFFSET || off == CISR_OFFSET)
+        return true;
+
+    // group start bit is cleared by hardware
+    if(off >= PGR0_OFFSET && off <= PGR3_OFFSET)
+        return true;
+
+    if(off < PCR_OFFSET)
+        return false;
+
+    // PCNTR, PPCNTR, CCR, CRLR and CFLR of each channel
+    uint32_t reg = (off - PCR_OFFSET) % PWM_REG_OFFSET(0, 1);
+    return (reg >= PCNTR_OFFSET - PCR_OFFSET) && (reg <= CFLR_OFFSET - PCR_OFFSET);
+}
+
+static struct rw_shadow *find_shadow(void *addr, uint32_t *off)
+{
+    for(uint8_t i = 0; i < nr_shadow; i++) {
+        uintptr_t o = (uintptr_t)addr - shadows[i].base;
+        if(o < PWM_WINDOW_SIZE) {
+            *off = o;
+            return &shadows[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void load_shadow(struct rw_shadow *s)
+{
+    volatile uint32_t *hw = (volatile uint32_t *)s->base;
+
+    for(uint32_t off = 0; off < PWM_WINDOW_SIZE; off += 4)
+        s->regs[off / 4] = is_volatile(off) ? 0 : hw[off / 4];
+}
+
+static struct rw_window *find_window(void *addr, uint32_t *off)
 {
-    uint32_t *reg = (uint32_t *)base;
+    for(uint8_t i = 0; i < nr_window; i++) {
+        uintptr_t o = (uintptr_t)addr - windows[i].base;
+        if(o < PWM_WINDOW_SIZE) {
+            *off = o;
+            return &windows[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Invalidate counter clock of channels which use this register
+ * @note Only windows registered by rw_window_attach() are tracked, offset is
+ *       taken from window base (no alignment is assumed)
+ */
+static void track_clk(void *addr)
+{
+    uint32_t off;
+    struct rw_window *w = nr_window ? find_window(addr, &off) : NULL;
+    if(!w)
+        return;
+
+    // epochs may be read by other threads (e.g callbacks of reactor)
+    if(off >= PCCR01_OFFSET && off <= PCCR57_OFFSET) {
+        uint8_t ch = ((off - PCCR01_OFFSET) / 4) * 2;
+        __atomic_fetch_add(&w->clk_epoch[ch], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&w->clk_epoch[ch + 1], 1, __ATOMIC_RELAXED);
+    } else if(off >= PCR_OFFSET && off < PWM_REG_OFFSET(PCR_OFFSET, PWM_CHANNEL) &&
+              !((off - PCR_OFFSET) % PWM_REG_BLOCK_SIZE)) {
+        __atomic_fetch_add(&w->clk_epoch[(off - PCR_OFFSET) / PWM_REG_BLOCK_SIZE], 1,
+                           __ATOMIC_RELAXED);
+    }
+}
+
+int32_t rw_window_attach(void *base)
+{
+    uint32_t off;
+
+    if(!base)
+        return -EFAULT;
+
+    if(find_window(base, &off))
+        return -EBUSY;
+
+    if(nr_window == RW_MAX_WINDOW)
+        return -ENOMEM;
+
+    struct rw_window *w = &windows[nr_window];
+    memset(w, 0, sizeof(*w));
+    w->base = (uintptr_t)base;
+    nr_window++;
+
+    return 0;
+}
+
+int32_t rw_window_detach(void *base)
+{
+    uint32_t off;
+    struct rw_window *w = find_window(base, &off);
+    if(!w || off)
+        return -ENOENT;
+
+    // keep table packed
+    *w = windows[--nr_window];
+
+    return 0;
+}
+
+int32_t rw_clk_epoch(void *base, uint8_t ch, uint32_t *epoch)
+{
+    if(ch >= PWM_CHANNEL)
+        return -EINVAL;
+
+    if(!epoch)
+        return -EFAULT;
+
+    uint32_t off;
+    struct rw_window *w = find_window(base, &off);
+    if(!w || off)
+        return -ENOENT;
+
+    *epoch = __atomic_load_n(&w->clk_epoch[ch], __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+void writel_relaxed(void* base, uint32_t value)
+{
+    volatile uint32_t *reg = (volatile uint32_t *)base;
     *reg = value;
+    RW_TRACE_ACCESS(base, true);
+    track_clk(base);
+
+    // no shadow attached: plain store
+    if(!nr_shadow)
+        return;
+
+    uint32_t off;
+    struct rw_shadow *s = find_shadow(base, &off);
+    if(s) {
+        s->stats.writes++;
+        if(!is_volatile(off))
+            s->regs[off / 4] = value;
+    }
 }
 
-uint32_t readl(void* base)
+uint32_t readl_relaxed(void* base)
 {
-    uint32_t *reg = (uint32_t *)base;
+    uint32_t off;
+    struct rw_shadow *s = nr_shadow ? find_shadow(base, &off) : NULL;
+    if(s) {
+        s->stats.reads++;
+        if(!is_volatile(off)) {
+            s->stats.saved_reads++;
+            return s->regs[off / 4];
+        }
+        s->stats.mmio_reads++;
+    }
+
+    volatile uint32_t *reg = (volatile uint32_t *)base;
+    RW_TRACE_ACCESS(base, false);
     return *reg;
 }
 
+void writel(void* base, uint32_t value)
+{
+    rw_wmb();
+    writel_relaxed(base, value);
+}
+
+uint32_t readl(void* base)
+{
+    uint32_t value = readl_relaxed(base);
+    rw_rmb();
+
+    return value;
+}
+
+void readsl(void *base, uint32_t *buf, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+        buf[i] = readl_relaxed(base + 4 * i);
+    rw_rmb();
+}
+
+void writesl(void *base, const uint32_t *buf, uint32_t count)
+{
+    rw_wmb();
+    for(uint32_t i = 0; i < count; i++)
+        writel_relaxed(base + 4 * i, buf[i]);
+}
+
 void rmwb(void *base, uint8_t index, bool bit)
 {
     if(index > 31)
         return;
 
-    uint32_t reg = readl(base);
+    uint32_t reg = readl_relaxed(base);
     if(bit)
         SET_BIT(reg, index);
     else
         CLEAR_BIT(reg, index);
     writel(base, reg);
-}
\ No newline at end of file
+}
+
+int32_t rw_shadow_attach(void *base)
+{
+    uint32_t off;
+
+    if(!base)
+        return -EFAULT;
+
+    if(find_shadow(base, &off))
+        return -EBUSY;
+
+    if(nr_shadow == RW_MAX_SHADOW)
+        return -ENOMEM;
+
+    struct rw_shadow *s = &shadows[nr_shadow];
+    memset(s, 0, sizeof(*s));
+    s->base = (uintptr_t)base;
+    load_shadow(s);
+    nr_shadow++;
+
+    return 0;
+}
+
+int32_t rw_shadow_detach(void *base)
+{
+    uint32_t off;
+    struct rw_shadow *s = find_shadow(base, &off);
+    if(!s || off)
+        return -ENOENT;
+
+    // keep table packed
+    struct rw_shadow *last = &shadows[nr_shadow - 1];
+    if(s != last)
+        memcpy(s, last, sizeof(*s));
+    nr_shadow--;
+
+    return 0;
+}
+
+int32_t rw_shadow_sync(void *base)
+{
+    uint32_t off;
+    struct rw_shadow *s = find_shadow(base, &off);
+    if(!s || off)
+        return -ENOENT;
+
+    load_shadow(s);
+
+    return 0;
+}
+
+int32_t rw_shadow_stats(void *base, struct rw_shadow_stats *stats)
+{
+    if(!stats)
+        return -EFAULT;
+
+    uint32_t off;
+    struct rw_shadow *s = find_shadow(base, &off);
+    if(!s || off)
+        return -ENOENT;
+
+    *stats = s->stats;
+
+    return 0;
+}
+
+void rw_txn_begin(struct rw_txn *txn, void *base)
+{
+    txn->base = base;
+    txn->nr = 0;
+    txn->err = base ? 0 : -EFAULT;
+}
+
+static struct rw_txn_reg *txn_reg(struct rw_txn *txn, uint32_t off)
+{
+    for(uint8_t i = 0; i < txn->nr; i++)
+        if(txn->regs[i].off == off)
+            return &txn->regs[i];
+
+    if(txn->nr == RW_TXN_MAX) {
+        txn->err = -ENOSPC;
+        return NULL;
+    }
+
+    struct rw_txn_reg *reg = &txn->regs[txn->nr++];
+    reg->off = off;
+    reg->set = 0;
+    reg->clr = 0;
+
+    return reg;
+}
+
+void rw_txn_field(struct rw_txn *txn, uint32_t off, uint32_t mask, uint32_t value)
+{
+    if(off >= PWM_WINDOW_SIZE || (off & 0x03)) {
+        txn->err = -EINVAL;
+        return;
+    }
+
+    struct rw_txn_reg *reg = txn_reg(txn, off);
+    if(!reg)
+        return;
+
+    reg->set = (reg->set & ~mask) | (value & mask);
+    reg->clr = (reg->clr & ~mask) | (~value & mask);
+}
+
+void rw_txn_bit(struct rw_txn *txn, uint32_t off, uint8_t index, bool bit)
+{
+    if(index > 31) {
+        txn->err = -EINVAL;
+        return;
+    }
+
+    rw_txn_field(txn, off, BIT(index), bit ? BIT(index) : 0);
+}
+
+void rw_txn_write(struct rw_txn *txn, uint32_t off, uint32_t value)
+{
+    rw_txn_field(txn, off, 0xFFFFFFFF, value);
+}
+
+int32_t rw_txn_commit(struct rw_txn *txn)
+{
+    if(txn->err)
+        return txn->err;
+
+    /**
+     * @brief Registers are accessed back to back (relaxed). Enable registers
+     *        must not be written before previous configuration is visible
+     */
+    rw_wmb();
+    for(uint8_t i = 0; i < txn->nr; i++) {
+        struct rw_txn_reg *reg = &txn->regs[i];
+        void *addr = txn->base + reg->off;
+
+        uint32_t value = reg->set;
+        if((reg->set | reg->clr) != 0xFFFFFFFF)
+            value |= readl_relaxed(addr) & ~reg->clr;
+
+        if(reg->off == PER_OFFSET || reg->off == CER_OFFSET)
+            writel(addr, value);
+        else
+            writel_relaxed(addr, value);
+    }
+    txn->nr = 0;
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file snapshot.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Whole PWM block state in single pass
+ * @version 0.1
+ * @date 2024-10-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+
+#include "soc.h"
+#include "trace.h"
+#include "rw.h"
+#include "registers.h"
+#include "bitops.h"
+#include "snapshot.h"
+
+#define CH_REGS     (PWM_REG_BLOCK_SIZE / 4)
+#define REG(off)    (((off) - PCR_OFFSET) / 4)
+
+int32_t pwm_snapshot(void *p, struct pwm_snapshot *snap)
+{
+    RW_TRACE_API();
+
+    if(!p || !snap)
+        return -EFAULT;
+
+    uint32_t irq[(CISR_OFFSET - PIER_OFFSET) / 4 + 1];
+    uint32_t blk[PWM_CHANNEL * CH_REGS];
+
+    // one pass in ascending order over 0x400 window
+    readsl(p + PIER_OFFSET, irq, sizeof(irq) / sizeof(irq[0]));
+    readsl(p + PCCR01_OFFSET, snap->pccr, PWM_CHANNEL / 2);
+    snap->pcgr = readl_relaxed(p + PCGR_OFFSET);
+    snap->per = readl_relaxed(p + PER_OFFSET);
+    snap->cer = readl_relaxed(p + CER_OFFSET);
+    readsl(p + PCR_OFFSET, blk, PWM_CHANNEL * CH_REGS);
+
+    snap->pier = irq[(PIER_OFFSET - PIER_OFFSET) / 4];
+    snap->pisr = irq[(PISR_OFFSET - PIER_OFFSET) / 4];
+    snap->cier = irq[(CIER_OFFSET - PIER_OFFSET) / 4];
+    snap->cisr = irq[(CISR_OFFSET - PIER_OFFSET) / 4];
+
+    int32_t ret = 0;
+    for(uint8_t ch = 0; ch < PWM_CHANNEL; ch++) {
+        struct pwm_ch_state *st = &snap->ch[ch];
+        const uint32_t *regs = &blk[ch * CH_REGS];
+        uint32_t pccr = snap->pccr[ch / 2];
+
+        if(GET_CLK_DIV(pccr) > DIV_256)
+            ret = -EINVAL;
+
+        st->pwm.clk.src = IS_SET(pccr, PWM_CLK_SRC_SEL) ? APB0 : HOSC;
+        st->pwm.clk.div = GET_CLK_DIV(pccr);
+        st->pwm.pre = GET_PWM_PRESCALER(regs[REG(PCR_OFFSET)]);
+        st->pwm.state = IS_SET(regs[REG(PCR_OFFSET)], PWM_ACT_STA) ? ACT_HIGH : ACT_LOW;
+        st->pwm.period.act = GET_PWM_ACT(regs[REG(PPR_OFFSET)]);
+        st->pwm.period.entire = GET_PWM_ENTIRE(regs[REG(PPR_OFFSET)]);
+        st->pwm.en = IS_SET(snap->per, PWMx_EN(ch));
+
+        st->gated = IS_SET(snap->pcgr, PWMx_CLK_GATING(ch));
+        st->bypass = IS_SET(snap->pcgr, PWMx_CLK_BYPASS(ch));
+        st->pis = IS_SET(snap->pisr, ch);
+
+        st->cap_en = IS_SET(snap->cer, CAPx_EN(ch));
+        st->rising = IS_SET(regs[REG(CCR_OFFSET)], CRTE);
+        st->falling = IS_SET(regs[REG(CCR_OFFSET)], CFTE);
+        st->crlf = IS_SET(regs[REG(CCR_OFFSET)], CRLF);
+        st->cflf = IS_SET(regs[REG(CCR_OFFSET)], CFLF);
+        st->cris = IS_SET(snap->cisr, CRISx(ch));
+        st->cfis = IS_SET(snap->cisr, CFISx(ch));
+
+        st->cnt = regs[REG(PCNTR_OFFSET)] & 0xFFFF;
+        st->pulse_cnt = PPCNTR(regs[REG(PPCNTR_OFFSET)]);
+        st->rlock = CRLR(regs[REG(CRLR_OFFSET)]);
+        st->flock = CFLR(regs[REG(CFLR_OFFSET)]);
+    }
+
+    return ret;
+}
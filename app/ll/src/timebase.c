@@ -0,0 +1,126 @@
+/**
+ * @file timebase.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Division free cycles <-> nS conversion (fixed point reciprocal)
+ * @version 0.1
+ * @date 2024-10-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <errno.h>
+#include <stddef.h>
+
+#include "soc.h"
+#include "rw.h"
+#include "registers.h"
+#include "bitops.h"
+#include "timebase.h"
+
+/**
+ * @brief Largest Q format of num / den which fits in 32bit
+ * @note Long division, so intermediate values never overflow
+ */
+static void reciprocal(uint64_t num, uint64_t den, uint32_t *mul, uint8_t *shift)
+{
+    uint64_t q = num / den;
+    uint64_t r = num % den;
+    uint8_t s = 0;
+
+    // append fractional bits while result fits in 32bit
+    while(s < 63 && q < BIT(31)) {
+        r <<= 1;
+        q <<= 1;
+        if(r >= den) {
+            r -= den;
+            q |= 1;
+        }
+        s++;
+    }
+
+    // round to nearest
+    if(2 * r >= den && q < UINT32_MAX)
+        q++;
+
+    *mul = q;
+    *shift = s;
+}
+
+int32_t timebase_init(struct pwm_timebase *tb, struct pwm_clk clk, uint8_t pre)
+{
+    if(!tb)
+        return -EFAULT;
+
+    if(check_clk(clk))
+        return -EINVAL;
+
+    uint64_t freq = (clk.src == APB0) ? APB0_FREQ : HOSC_FREQ;
+    uint64_t total = BIT(clk.div) * (pre + 1);
+
+    // nS per cycle = total * NSEC_IN_SEC / freq
+    reciprocal(total * NSEC_IN_SEC, freq, &tb->ns_mul, &tb->ns_shift);
+    reciprocal(freq, total * NSEC_IN_SEC, &tb->cyc_mul, &tb->cyc_shift);
+    tb->tick_hz = (freq + total / 2) / total;
+    tb->src_hz = freq;
+    tb->div = total;
+
+    return 0;
+}
+
+/**
+ * @brief Timebase cache of single channel
+ *
+ */
+struct tb_cache {
+    void *base;
+    uint32_t epoch;             // rw_clk_epoch() when timebase was built
+    struct pwm_timebase tb;
+};
+
+static struct tb_cache cache[PWM_CHANNEL];
+
+int32_t timebase_update(void *base, uint8_t ch, struct pwm_clk clk, uint8_t pre)
+{
+    if(check_ch(ch))
+        return -EINVAL;
+
+    struct tb_cache *c = &cache[ch];
+    int32_t ret = timebase_init(&c->tb, clk, pre);
+    if(ret) {
+        c->base = NULL;
+        return ret;
+    }
+
+    // windows which aren't tracked (check rw_window_attach()) are never cached
+    c->base = rw_clk_epoch(base, ch, &c->epoch) ? NULL : base;
+
+    return 0;
+}
+
+int32_t timebase_get(void *base, uint8_t ch, struct pwm_timebase *tb)
+{
+    if(check_ch(ch))
+        return -EINVAL;
+
+    if(!base || !tb)
+        return -EFAULT;
+
+    struct tb_cache *c = &cache[ch];
+    uint32_t epoch;
+    if(c->base != base || rw_clk_epoch(base, ch, &epoch) || c->epoch != epoch) {
+        uint32_t pccr = readl_relaxed(base + PCCRxy_OFFSET(ch));
+        uint32_t pcr = readl(base + PWM_REG_OFFSET(PCR_OFFSET, ch));
+        struct pwm_clk clk = {
+            .src = IS_SET(pccr, PWM_CLK_SRC_SEL) ? APB0 : HOSC,
+            .div = GET_CLK_DIV(pccr)
+        };
+
+        int32_t ret = timebase_update(base, ch, clk, GET_PWM_PRESCALER(pcr));
+        if(ret)
+            return ret;
+    }
+
+    *tb = c->tb;
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file trace.c
+ * @author Arash Golgol (arash.golgol@gmail.com)
+ * @brief Register access accounting (per register and per API)
+ * @version 0.1
+ * @date 2024-10-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "trace.h"
+
+#ifdef RW_TRACE
+#include <string.h>
+#include <time.h>
+
+#include "soc.h"
+#include "registers.h"
+
+#define RW_TRACE_MAX_API    64
+
+/**
+ * @brief Accounting of single API
+ *
+ */
+struct rw_trace_api {
+    const char *name;
+    uint64_t calls;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t ns;
+};
+
+static uint64_t reg_reads[PWM_WINDOW_SIZE / 4];
+static uint64_t reg_writes[PWM_WINDOW_SIZE / 4];
+
+static struct rw_trace_api apis[RW_TRACE_MAX_API];
+static uint8_t nr_api;
+
+static __thread struct rw_trace_api *current;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_IN_SEC + ts.tv_nsec;
+}
+
+static struct rw_trace_api *find_api(const char *name)
+{
+    for(uint8_t i = 0; i < nr_api; i++)
+        if(apis[i].name == name || !strcmp(apis[i].name, name))
+            return &apis[i];
+
+    if(nr_api == RW_TRACE_MAX_API)
+        return NULL;
+
+    apis[nr_api].name = name;
+    return &apis[nr_api++];
+}
+
+struct rw_trace_scope rw_trace_enter(const char *name)
+{
+    struct rw_trace_scope scope = {.api = NULL, .start_ns = 0};
+
+    // nested call is accounted to caller
+    if(current)
+        return scope;
+
+    scope.api = find_api(name);
+    if(scope.api) {
+        current = scope.api;
+        scope.start_ns = now_ns();
+    }
+
+    return scope;
+}
+
+void rw_trace_leave(struct rw_trace_scope *scope)
+{
+    if(!scope->api)
+        return;
+
+    scope->api->ns += now_ns() - scope->start_ns;
+    scope->api->calls++;
+    current = NULL;
+}
+
+void rw_trace_access(void *addr, bool write)
+{
+    // PWM window is 0x400 aligned in every backend
+    uint32_t off = (uintptr_t)addr & (PWM_WINDOW_SIZE - 1);
+
+    if(write)
+        reg_writes[off / 4]++;
+    else
+        reg_reads[off / 4]++;
+
+    if(current) {
+        if(write)
+            current->writes++;
+        else
+            current->reads++;
+    }
+}
+
+static const char *reg_name(uint32_t off, char *buf, size_t len)
+{
+    static const struct {
+        uint32_t off;
+        const char *name;
+    } regs[] = {
+        {PIER_OFFSET, "PIER"},      {PISR_OFFSET, "PISR"},
+        {CIER_OFFSET, "CIER"},      {CISR_OFFSET, "CISR"},
+        {PCCR01_OFFSET, "PCCR01"},  {PCCR23_OFFSET, "PCCR23"},
+        {PCCR45_OFFSET, "PCCR45"},  {PCCR57_OFFSET, "PCCR67"},
+        {PCGR_OFFSET, "PCGR"},
+        {PDZCR01_OFFSET, "PDZCR01"},{PDZCR23_OFFSET, "PDZCR23"},
+        {PDZCR45_OFFSET, "PDZCR45"},{PDZCR67_OFFSET, "PDZCR67"},
+        {PER_OFFSET, "PER"},
+        {PGR0_OFFSET, "PGR0"},      {PGR1_OFFSET, "PGR1"},
+        {PGR2_OFFSET, "PGR2"},      {PGR3_OFFSET, "PGR3"},
+        {CER_OFFSET, "CER"},
+    };
+    static const char *ch_regs[] = {
+        "PCR", "PPR", "PCNTR", "PPCNTR", "CCR", "CRLR", "CFLR", "RSVD"
+    };
+
+    if(off >= PCR_OFFSET) {
+        uint32_t ch = (off - PCR_OFFSET) / PWM_REG_BLOCK_SIZE;
+        uint32_t reg = ((off - PCR_OFFSET) % PWM_REG_BLOCK_SIZE) / 4;
+        snprintf(buf, len, "%s%u", ch_regs[reg], ch);
+        return buf;
+    }
+
+    for(size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+        if(regs[i].off == off)
+            return regs[i].name;
+
+    snprintf(buf, len, "0x%03x", off);
+    return buf;
+}
+
+void rw_trace_dump(FILE *f)
+{
+    char buf[16];
+
+    fprintf(f, "%-10s %12s %12s\n", "register", "reads", "writes");
+    for(uint32_t i = 0; i < PWM_WINDOW_SIZE / 4; i++) {
+        if(!reg_reads[i] && !reg_writes[i])
+            continue;
+        fprintf(f, "%-10s %12llu %12llu\n", reg_name(i * 4, buf, sizeof(buf)),
+                (unsigned long long)reg_reads[i], (unsigned long long)reg_writes[i]);
+    }
+
+    fprintf(f, "\n%-20s %10s %10s %10s %12s %10s\n",
+            "api", "calls", "reads", "writes", "total_us", "avg_ns");
+    for(uint8_t i = 0; i < nr_api; i++) {
+        struct rw_trace_api *api = &apis[i];
+        fprintf(f, "%-20s %10llu %10llu %10llu %12llu %10llu\n", api->name,
+                (unsigned long long)api->calls, (unsigned long long)api->reads,
+                (unsigned long long)api->writes, (unsigned long long)(api->ns / 1000),
+                (unsigned long long)(api->calls ? api->ns / api->calls : 0));
+    }
+}
+
+void rw_trace_reset(void)
+{
+    memset(reg_reads, 0, sizeof(reg_reads));
+    memset(reg_writes, 0, sizeof(reg_writes));
+    memset(apis, 0, sizeof(apis));
+    nr_api = 0;
+}
+
+#endif // RW_TRACE
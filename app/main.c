@@ -1,17 +1,20 @@
 #include <stdio.h>
-#include <fcntl.h>
 #include <unistd.h>
-#include <sys/mman.h>
-#include <sys/types.h>
 #include <errno.h>
+#include <string.h>
 
+#include "backend.h"
 #include "config.h"
 
 int main() {
     // UIO memory mapped device
-    int fd = open("/dev/uio0", O_RDWR);
-    void *p = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-    p += 0xc00;
+    struct rw_backend be;
+    int32_t ret = rw_open_uio(&be, "/dev/uio0");
+    if(ret) {
+        fprintf(stderr, "/dev/uio0: %s\n", strerror(-ret));
+        return 1;
+    }
+    void *p = be.base;
 
     // PWM channel
     struct pwm_config pwm = {
@@ -53,7 +56,6 @@ int main() {
     cap_en(p, 4, false, false);
     pwm_en(p, 2, false);
 
-    munmap(p, 4096);
-    close(fd);
+    rw_close(&be);
     return 0;
 }
\ No newline at end of file
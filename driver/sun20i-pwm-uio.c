@@ -15,18 +15,68 @@
 #include <linux/reset.h>
 #include <linux/clk.h>
 #include <linux/uio_driver.h>
+#include <linux/interrupt.h>
+#include <linux/spinlock.h>
+#include <linux/bitops.h>
+#include <linux/io.h>
+
+#define PWM_PIER        0x0000  /* PWM IRQ Enable Register */
+#define PWM_PISR        0x0004  /* PWM IRQ Status Register */
+#define PWM_CIER        0x0010  /* Capture IRQ Enable Register */
+#define PWM_CISR        0x0014  /* Capture IRQ Status Register */
+
+#define PWM_IRQ_DISABLED    0   /* bit of sun20i_pwm.flags */
 
 struct sun20i_pwm {
     struct clk *bus_clk;
     struct reset_control *rstc;
     void __iomem *base;
+    spinlock_t lock;
+    unsigned long flags;
 };
 
+/*
+ * Line is level triggered and status flags are cleared by userspace, so
+ * keep it masked until userspace re-arms it by writing 1 to UIO device.
+ * PISR latches every period of running channels even if PIER doesn't
+ * enable them, so only enabled status bits claim the interrupt
+ */
 static irqreturn_t pwm_irqhander(int irq, struct uio_info *dev_info)
 {
+    struct sun20i_pwm *pwm = dev_info->priv;
+    u32 pending;
+
+    pending = readl(pwm->base + PWM_PISR) & readl(pwm->base + PWM_PIER);
+    pending |= readl(pwm->base + PWM_CISR) & readl(pwm->base + PWM_CIER);
+    if(!pending)
+        return IRQ_NONE;
+
+    spin_lock(&pwm->lock);
+    if(!__test_and_set_bit(PWM_IRQ_DISABLED, &pwm->flags))
+        disable_irq_nosync(irq);
+    spin_unlock(&pwm->lock);
+
     return IRQ_HANDLED;
 }
 
+static int pwm_irqcontrol(struct uio_info *dev_info, s32 irq_on)
+{
+    struct sun20i_pwm *pwm = dev_info->priv;
+    unsigned long flags;
+
+    spin_lock_irqsave(&pwm->lock, flags);
+    if(irq_on) {
+        if(__test_and_clear_bit(PWM_IRQ_DISABLED, &pwm->flags))
+            enable_irq(dev_info->irq);
+    } else {
+        if(!__test_and_set_bit(PWM_IRQ_DISABLED, &pwm->flags))
+            disable_irq_nosync(dev_info->irq);
+    }
+    spin_unlock_irqrestore(&pwm->lock, flags);
+
+    return 0;
+}
+
 static const struct of_device_id sun20i_of_device_ids[] = {
     { .compatible = "allwinner,sun20i-pwm-uio" },
     { /* sentinel */ }
@@ -51,6 +101,7 @@ static int sun20i_pwm_probe(struct platform_device *pdev)
         return -ENOMEM;
 
     info->priv = pwm;
+    spin_lock_init(&pwm->lock);
 
     res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
     if(unlikely(res == NULL)) {
@@ -106,6 +157,7 @@ static int sun20i_pwm_probe(struct platform_device *pdev)
     info->irq = irq;
     info->irq_flags = 0;
     info->handler = &pwm_irqhander;
+    info->irqcontrol = &pwm_irqcontrol;
 
     ret = devm_uio_register_device(dev, info);
     if(ret) {